@@ -0,0 +1,38 @@
+#!/bin/sh
+# array-buffer-pool.sh - Compare pooled ArrayBuffer stores with calloc()
+#
+# Usage: array-buffer-pool.sh [buffers] moka...
+#
+# Allocates and drops ArrayBuffers of 16 B to 64 KiB, touching the first
+# bytes of each, and reports the wall time of each moka shell with the
+# buffer pool disabled (MOKAPOOL=0) and enabled (MOKAPOOL=1).
+
+BUFFERS=${1:-1000000}
+shift 2>/dev/null
+[ $# -gt 0 ] || set -- moka
+
+directory=$(mktemp -d) || exit 1
+trap 'rm -rf "$directory"' EXIT
+
+cat > "$directory/main.js" <<MAIN
+var sizes = [];
+for (var size = 16; size <= 65536; size *= 2) {
+  sizes.push(size, size - size / 4);
+}
+for (var index = 0; index < $BUFFERS; ++index) {
+  var bytes = new Uint8Array(new ArrayBuffer(sizes[index % sizes.length]));
+  bytes[0] = bytes[15] = index & 0xff;
+}
+MAIN
+
+run() {
+	start=$(date +%s%N)
+	MOKAPOOL=$2 "$1" "$directory/main.js" || exit 1
+	end=$(date +%s%N)
+	echo $(((end - start) / 1000000))
+}
+
+echo "buffers: $BUFFERS"
+for moka in "$@"; do
+	echo "$moka: $(run "$moka" 0) ms calloc, $(run "$moka" 1) ms pool"
+done
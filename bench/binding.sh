@@ -0,0 +1,38 @@
+#!/bin/sh
+# binding.sh - Measure the overhead of calls into native methods
+#
+# Usage: binding.sh [calls] moka...
+#
+# Calls a few native methods bound through the binding templates in a
+# tight loop and reports the time per call of each moka shell, e.g., of
+# builds before and after a change to the argument checking.
+
+CALLS=${1:-1000000}
+shift 2>/dev/null
+[ $# -gt 0 ] || set -- moka
+
+directory=$(mktemp -d) || exit 1
+trap 'rm -rf "$directory"' EXIT
+
+cat > "$directory/main.js" <<MAIN
+var calls = $CALLS;
+var array = new Uint32Array(16);
+var view = new DataView(array.buffer);
+function measure(name, call) {
+  var start = new Date().getTime();
+  for (var index = 0; index < calls; ++index) {
+    call(index & 15);
+  }
+  var ns = (new Date().getTime() - start) * 1000000 / calls;
+  print(name + ': ' + ns.toFixed(1) + ' ns/call');
+}
+measure('getUint32', function(index) { view.getUint32(index * 4, true); });
+measure('setUint32', function(index) { view.setUint32(index * 4, index); });
+measure('get', function(index) { array.get(index); });
+MAIN
+
+echo "calls: $CALLS"
+for moka in "$@"; do
+	echo "$moka:"
+	"$moka" "$directory/main.js" | sed 's/^/  /' || exit 1
+done
@@ -0,0 +1,43 @@
+#!/bin/sh
+# context-globals.sh - Measure the cost of module context creation
+#
+# Usage: context-globals.sh [modules] [runs] moka...
+#
+# Generates a main script requiring a number of small modules that never
+# touch the built-in constructors and reports the wall time and the V8
+# heap in use (from MOKASTATS) of each moka shell, e.g., of builds before
+# and after a change to the module globals.
+
+MODULES=${1:-200}
+RUNS=${2:-10}
+shift 2 2>/dev/null
+[ $# -gt 0 ] || set -- moka
+
+directory=$(mktemp -d) || exit 1
+trap 'rm -rf "$directory"' EXIT
+
+index=0
+: > "$directory/main.js"
+while [ $index -lt $MODULES ]; do
+	echo "exports.value = $index;" > "$directory/module$index.js"
+	echo "require('./module$index');" >> "$directory/main.js"
+	index=$((index + 1))
+done
+
+run() {
+	start=$(date +%s%N)
+	run=0
+	while [ $run -lt $RUNS ]; do
+		"$1" "$directory/main.js" || exit 1
+		run=$((run + 1))
+	done
+	end=$(date +%s%N)
+	echo $(((end - start) / RUNS / 1000))
+}
+
+echo "modules: $MODULES, runs: $RUNS"
+for moka in "$@"; do
+	heap=$(MOKASTATS=1 "$moka" "$directory/main.js" 2>&1 >/dev/null \
+		| sed -n 's/^heap: \([0-9]*\) bytes used.*/\1/p')
+	echo "$moka: $(run "$moka") us/run, $heap bytes heap used"
+done
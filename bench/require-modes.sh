@@ -0,0 +1,41 @@
+#!/bin/sh
+# require-modes.sh - Compare isolated and shared context module loading
+#
+# Usage: require-modes.sh [moka] [modules] [runs]
+#
+# Generates a main script requiring a number of small modules and reports
+# the wall time of the moka shell with one context per module (default)
+# and with MOKASHARED set.
+
+MOKA=${1:-moka}
+MODULES=${2:-200}
+RUNS=${3:-10}
+
+directory=$(mktemp -d) || exit 1
+trap 'rm -rf "$directory"' EXIT
+
+index=0
+: > "$directory/main.js"
+while [ $index -lt $MODULES ]; do
+	cat > "$directory/module$index.js" <<MODULE
+exports.value = $index;
+exports.twice = function (x) { return 2 * x; };
+MODULE
+	echo "require('./module$index');" >> "$directory/main.js"
+	index=$((index + 1))
+done
+
+run() {
+	start=$(date +%s%N)
+	run=0
+	while [ $run -lt $RUNS ]; do
+		"$@" "$MOKA" "$directory/main.js" || exit 1
+		run=$((run + 1))
+	done
+	end=$(date +%s%N)
+	echo $(((end - start) / RUNS / 1000))
+}
+
+echo "modules: $MODULES, runs: $RUNS"
+echo "isolated: $(run env) us/run"
+echo "shared:   $(run env MOKASHARED=1) us/run"
@@ -0,0 +1,33 @@
+#!/bin/sh
+# startup.sh - Measure the cold start latency of the moka shell
+#
+# Usage: startup.sh [runs] moka...
+#
+# Runs a script that requires a typed array, i.e., forces the built-in
+# templates to be created, and reports the wall time per run and the
+# startup phases (from MOKASTATS) of each moka shell.
+
+RUNS=${1:-50}
+shift 2>/dev/null
+[ $# -gt 0 ] || set -- moka
+
+directory=$(mktemp -d) || exit 1
+trap 'rm -rf "$directory"' EXIT
+
+cat > "$directory/main.js" <<MAIN
+new DataView(new Uint8Array(16).buffer);
+MAIN
+
+echo "runs: $RUNS"
+for moka in "$@"; do
+	start=$(date +%s%N)
+	run=0
+	while [ $run -lt $RUNS ]; do
+		"$moka" "$directory/main.js" || exit 1
+		run=$((run + 1))
+	done
+	end=$(date +%s%N)
+	phases=$(MOKASTATS=1 "$moka" "$directory/main.js" 2>&1 >/dev/null \
+		| sed -n 's/^startup: //p')
+	echo "$moka: $(((end - start) / RUNS / 1000)) us/run ($phases)"
+done
@@ -0,0 +1,56 @@
+#!/bin/sh
+# stream-write.sh - Measure the overhead of stream method calls
+#
+# Usage: stream-write.sh [calls] moka...
+#
+# Calls write('') and flush() on a stream implemented in JavaScript on top
+# of io.Stream, and on a native io.FileStream opened on /dev/null if the
+# io module provides one, and reports the time per call of each moka
+# shell, e.g., of builds before and after a change to the stream state
+# checks. An empty write stops after the state checks, so the numbers
+# measure the method dispatch rather than the write itself.
+
+CALLS=${1:-1000000}
+shift 2>/dev/null
+[ $# -gt 0 ] || set -- moka
+
+directory=$(mktemp -d) || exit 1
+trap 'rm -rf "$directory"' EXIT
+
+cat > "$directory/main.js" <<MAIN
+var io = require('io');
+var calls = $CALLS;
+function measure(name, call) {
+  var start = new Date().getTime();
+  for (var index = 0; index < calls; ++index) {
+    call();
+  }
+  var ns = (new Date().getTime() - start) * 1000000 / calls;
+  print(name + ': ' + ns.toFixed(1) + ' ns/call');
+}
+// A JavaScript stream keeps its state in ordinary properties
+var Script = function() {
+  this.closed = false;
+  this.readable = false;
+  this.writable = true;
+  this.seekable = false;
+};
+Script.prototype = Object.create(io.Stream.prototype);
+var script = new Script();
+measure('javascript write', function() { script.write(''); });
+measure('javascript flush', function() { script.flush(); });
+if (typeof io.FileStream === 'function') {
+  var file = new io.FileStream('/dev/null', 'w');
+  measure('native write', function() { file.write(''); });
+  measure('native flush', function() { file.flush(); });
+  file.close();
+} else {
+  print('native: io.FileStream is not available');
+}
+MAIN
+
+echo "calls: $CALLS"
+for moka in "$@"; do
+	echo "$moka:"
+	"$moka" "$directory/main.js" | sed 's/^/  /' || exit 1
+done
@@ -37,14 +37,11 @@
 namespace moka {
 
 ArrayBufferView::ArrayBufferView()
-  : byte_offset_(0)
+  : array_buffer_(NULL)
+  , byte_offset_(0)
   , byte_length_(0) {}
 
-ArrayBufferView::~ArrayBufferView() {
-  if (!array_buffer_.IsEmpty()) {
-    array_buffer_.Dispose();
-  }
-}
+ArrayBufferView::~ArrayBufferView() {}
 
 // Public interface
 v8::Handle<v8::FunctionTemplate> ArrayBufferView::GetTemplate() {
@@ -68,23 +65,21 @@ v8::Handle<v8::FunctionTemplate> ArrayBufferView::GetTemplate() {
 // Private V8 interface
 v8::Handle<v8::Value> ArrayBufferView::ArrayBuffer(
     v8::Local<v8::String> property, const v8::AccessorInfo &info) {
-  ArrayBufferView* self = static_cast<ArrayBufferView*>(
-      info.This()->GetPointerFromInternalField(0));
-  return self->array_buffer_;
+  return GetArrayBuffer(info.This());
 }
 
 v8::Handle<v8::Value> ArrayBufferView::ByteOffset(
     v8::Local<v8::String> property, const v8::AccessorInfo &info) {
   ArrayBufferView* self = static_cast<ArrayBufferView*>(
       info.This()->GetPointerFromInternalField(0));
-  return v8::Uint32::New(self->byte_offset_);
+  return v8::Number::New(static_cast<double>(self->byte_offset_));
 }
 
 v8::Handle<v8::Value> ArrayBufferView::ByteLength(
     v8::Local<v8::String> property, const v8::AccessorInfo &info) {
   ArrayBufferView* self = static_cast<ArrayBufferView*>(
       info.This()->GetPointerFromInternalField(0));
-  return v8::Uint32::New(self->byte_length_);
+  return v8::Number::New(static_cast<double>(self->byte_length_));
 }
 
 } // namespace moka
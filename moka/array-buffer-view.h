@@ -29,6 +29,7 @@
 #define MOKA_ARRAY_BUFFER_VIEW_H
 
 #include "moka/array-buffer.h"
+#include "moka/slab.h"
 #include <v8.h>
 
 namespace moka {
@@ -37,24 +38,57 @@ class ArrayBufferView;
 
 } // namespace moka
 
+/**
+ * \brief The native state of a view on an ArrayBuffer
+ *
+ * Views are allocated from a slab (see moka/slab.h) and hold no handles,
+ * the JavaScript object of a view keeps its ArrayBuffer alive in internal
+ * field kArrayBufferField.
+ */
 class moka::ArrayBufferView {
 public:
+  /// \brief Internal fields of a view object
+  enum {
+    kSelfField,
+    kArrayBufferField,
+    kInternalFieldCount
+  };
+
   static v8::Handle<v8::FunctionTemplate> GetTemplate();
 
-  v8::Handle<v8::Object> GetArrayBuffer() const {
-    return array_buffer_;
+  static void* operator new(size_t size) throw() {
+    return internal::Slab::Allocate(size);
+  }
+
+  static void operator delete(void* object, size_t size) {
+    internal::Slab::Free(object, size);
+  }
+
+  /**
+   * \brief Get the ArrayBuffer of a view
+   *
+   * \param view [in] A view object
+   *
+   * \return The ArrayBuffer object of view.
+   */
+  static v8::Handle<v8::Value> GetArrayBuffer(v8::Handle<v8::Object> view) {
+    return view->GetInternalField(kArrayBufferField);
   }
 
   void* GetBuffer() const {
-    return static_cast<moka::ArrayBuffer*>(
-        array_buffer_->GetPointerFromInternalField(0))->GetBuffer();
+    return array_buffer_->GetBuffer();
+  }
+
+  /// \brief Get the first byte of the view
+  int8_t* GetData() const {
+    return static_cast<int8_t*>(GetBuffer()) + byte_offset_;
   }
 
-  uint32_t GetByteOffset() const {
+  uint64_t GetByteOffset() const {
     return byte_offset_;
   }
 
-  uint32_t GetByteLength() const {
+  uint64_t GetByteLength() const {
     return byte_length_;
   }
 
@@ -73,9 +107,12 @@ protected: // Protected methods
 
   virtual ~ArrayBufferView();
 
-  v8::Handle<v8::Value> Construct(v8::Handle<v8::Object> array_buffer,
-      uint32_t byte_offset, uint32_t byte_length) {
-    array_buffer_ = v8::Persistent<v8::Object>::New(array_buffer);
+  v8::Handle<v8::Value> Construct(v8::Handle<v8::Object> view,
+      v8::Handle<v8::Object> array_buffer, uint64_t byte_offset,
+      uint64_t byte_length) {
+    view->SetInternalField(kArrayBufferField, array_buffer);
+    array_buffer_ = static_cast<moka::ArrayBuffer*>(
+        array_buffer->GetPointerFromInternalField(0));
     byte_offset_ = byte_offset;
     byte_length_ = byte_length;
     return v8::True();
@@ -87,9 +124,9 @@ private: // Private methods
   void operator=(ArrayBufferView const& that);
 
 protected: // Protected data
-  v8::Persistent<v8::Object> array_buffer_;
-  uint32_t byte_offset_;
-  uint32_t byte_length_;
+  moka::ArrayBuffer* array_buffer_;
+  uint64_t byte_offset_;
+  uint64_t byte_length_;
 };
 
 #endif // MOKA_ARRAY_BUFFER_VIEW_H
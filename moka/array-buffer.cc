@@ -31,7 +31,11 @@
 
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include "moka/array-buffer.h"
+#include "moka/binding.h"
+#include "moka/buffer-pool.h"
+#include "moka/external-memory.h"
 #include "moka/module.h"
 
 namespace moka {
@@ -42,8 +46,9 @@ ArrayBuffer::ArrayBuffer()
 
 ArrayBuffer::~ArrayBuffer() {
   if (buffer_) {
-    ::free(buffer_);
-    v8::V8::AdjustAmountOfExternalAllocatedMemory(-byte_length_);
+    internal::BufferPool::Free(buffer_, byte_length_);
+    internal::ExternalMemory::Adjust(internal::ExternalMemory::kArrayBuffer,
+        -static_cast<int64_t>(byte_length_));
   }
 }
 
@@ -66,8 +71,10 @@ v8::Handle<v8::FunctionTemplate> ArrayBuffer::GetTemplate() {
   return templ_;
 }
 
-v8::Handle<v8::Value> ArrayBuffer::New(uint32_t length) {
-  v8::Handle<v8::Value> argv[1] = { v8::Uint32::New(length) };
+v8::Handle<v8::Value> ArrayBuffer::New(uint64_t length) {
+  v8::Handle<v8::Value> argv[1] = {
+    v8::Number::New(static_cast<double>(length))
+  };
   return GetTemplate()->GetFunction()->NewInstance(1, argv);
 }
 
@@ -76,21 +83,27 @@ v8::Handle<v8::Value> ArrayBuffer::New(const v8::Arguments& arguments) {
   ArrayBuffer* self = NULL;
   switch (arguments.Length()) {
   case 1:
-    if (arguments[0]->IsUint32()) {
+    if (binding::Argument<uint64_t>::Is(arguments[0])) {
       self = new ArrayBuffer;
       if (self) {
-        self->byte_length_ = arguments[0]->ToUint32()->Value();
+        self->byte_length_ = binding::Argument<uint64_t>::Get(arguments[0]);
         if (self->byte_length_) {
-          self->buffer_ = ::calloc(self->byte_length_, sizeof(char));
+          if (static_cast<size_t>(self->byte_length_) != self->byte_length_) {
+            // Does not fit the address space
+            delete self;
+            return v8::ThrowException(Module::ErrnoException::New(ENOMEM));
+          }
+          self->buffer_ = internal::BufferPool::Allocate(self->byte_length_);
           if (!self->buffer_) {
             delete self;
             return v8::ThrowException(Module::ErrnoException::New(errno));
           }
+          internal::ExternalMemory::Adjust(
+              internal::ExternalMemory::kArrayBuffer, self->byte_length_);
         }
       }
     } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument one must be an unsigned integer")));
+      return binding::ThrowTypeError(0, binding::Argument<uint64_t>::Name());
     }
     break;
   default:
@@ -100,7 +113,8 @@ v8::Handle<v8::Value> ArrayBuffer::New(const v8::Arguments& arguments) {
   if (!self) {
     return v8::ThrowException(Module::ErrnoException::New(ENOMEM));
   }
-  v8::V8::AdjustAmountOfExternalAllocatedMemory(sizeof(ArrayBuffer));
+  internal::ExternalMemory::Adjust(internal::ExternalMemory::kArrayBuffer,
+      sizeof(ArrayBuffer));
   v8::Persistent<v8::Object> array_buffer =
     v8::Persistent<v8::Object>::New(arguments.This());
   array_buffer->SetInternalField(0, v8::External::New(self));
@@ -110,8 +124,8 @@ v8::Handle<v8::Value> ArrayBuffer::New(const v8::Arguments& arguments) {
 
 void ArrayBuffer::Delete(v8::Persistent<v8::Value> object, void* parameters) {
   delete static_cast<ArrayBuffer*>(parameters);
-  v8::V8::AdjustAmountOfExternalAllocatedMemory(
-      static_cast<int>(-sizeof(ArrayBuffer)));
+  internal::ExternalMemory::Adjust(internal::ExternalMemory::kArrayBuffer,
+      -static_cast<int64_t>(sizeof(ArrayBuffer)));
   object.Dispose();
   object.Clear();
 }
@@ -119,43 +133,37 @@ void ArrayBuffer::Delete(v8::Persistent<v8::Value> object, void* parameters) {
 v8::Handle<v8::Value> ArrayBuffer::Slice(const v8::Arguments& arguments) {
   ArrayBuffer* self = static_cast<ArrayBuffer*>(
       arguments.This()->GetPointerFromInternalField(0));
-  int32_t begin = 0, end = self->byte_length_;
+  int64_t begin = 0, end = self->byte_length_, index = 0;
   switch (arguments.Length()) {
     case 2:
-      if (arguments[1]->IsInt32()) {
-        int32_t index = arguments[1]->ToInt32()->Value();
-        if (index < end) {
-          if (index > 0) {
-            end = index;
-          } else {
-            end = 0;
-          }
+      if (!binding::Unpack(arguments, 1, &index)) {
+        return v8::Handle<v8::Value>();
+      }
+      if (index < end) {
+        if (index > 0) {
+          end = index;
+        } else {
+          end = 0;
         }
-      } else {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument two must be an integer")));
       }
       // Fall through
     case 1:
-      if (arguments[0]->IsInt32()) {
-        int32_t index = arguments[0]->ToInt32()->Value();
-        if (index > 0) {
-          if (index < end) {
-            begin = index;
-          } else {
-            begin = end;
-          }
+      if (!binding::Unpack(arguments, 0, &index)) {
+        return v8::Handle<v8::Value>();
+      }
+      if (index > 0) {
+        if (index < end) {
+          begin = index;
+        } else {
+          begin = end;
         }
-      } else {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be an integer")));
       }
       break;
     default:
       return v8::ThrowException(v8::Exception::TypeError(
             v8::String::New("One or two arguments allowed")));
   }
-  uint32_t length;
+  uint64_t length;
   if (end > begin) {
     length = end - begin;
   } else {
@@ -172,18 +180,15 @@ v8::Handle<v8::Value> ArrayBuffer::Slice(const v8::Arguments& arguments) {
   if (length) {
     ArrayBuffer* that = static_cast<ArrayBuffer*>(
         byte_array->ToObject()->GetPointerFromInternalField(0));
-    for (uint32_t index = 0; index < length; ++index) {
-      static_cast<char*>(that->buffer_)[index] =
-        static_cast<char*>(self->buffer_)[index + begin];
-    }
+    ::memcpy(that->buffer_, static_cast<char*>(self->buffer_) + begin, length);
   }
   return byte_array;
 }
 
 v8::Handle<v8::Value> ArrayBuffer::ByteLength(v8::Local<v8::String> property,
     const v8::AccessorInfo &info) {
-  return v8::Uint32::New(static_cast<ArrayBuffer*>(
-        info.This()->GetPointerFromInternalField(0))->byte_length_);
+  return v8::Number::New(static_cast<double>(static_cast<ArrayBuffer*>(
+        info.This()->GetPointerFromInternalField(0))->byte_length_));
 }
 
 } // namespace moka
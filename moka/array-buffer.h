@@ -40,13 +40,13 @@ class moka::ArrayBuffer {
 public:
   static v8::Handle<v8::FunctionTemplate> GetTemplate();
 
-  static v8::Handle<v8::Value> New(uint32_t length);
+  static v8::Handle<v8::Value> New(uint64_t length);
 
   void* GetBuffer() const {
     return buffer_;
   }
 
-  uint32_t GetByteLength() const {
+  uint64_t GetByteLength() const {
     return byte_length_;
   }
 
@@ -72,7 +72,7 @@ private: // Private methods
 
 protected: // Protected data
   void* buffer_;
-  uint32_t byte_length_;
+  uint64_t byte_length_;
 };
 
 #endif // MOKA_ARRAY_BUFFER_H
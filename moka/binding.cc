@@ -0,0 +1,86 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/binding.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include "moka/binding.h"
+#include <string>
+
+namespace moka {
+
+namespace binding {
+
+static const char* const kNumbers[] = {
+  "Zero", "One", "Two", "Three"
+};
+
+static const char* const kOrdinals[] = {
+  "zero", "one", "two", "three"
+};
+
+v8::Handle<v8::Value> ThrowArityError(int required, int arity) {
+  std::string message(kNumbers[required]);
+  if (required == arity) {
+    message.append(1 == arity ? " argument" : " arguments");
+    message.append(arity ? " required" : " allowed");
+  } else {
+    message.append(required + 1 == arity ? " or " : " to ");
+    message.append(kOrdinals[arity]);
+    message.append(" arguments allowed");
+  }
+  return v8::ThrowException(v8::Exception::TypeError(
+        v8::String::New(message.c_str())));
+}
+
+v8::Handle<v8::Value> ThrowTypeError(int index, const char* type) {
+  std::string message("Argument ");
+  message.append(kOrdinals[index + 1]);
+  message.append(" must be ");
+  message.append(type);
+  return v8::ThrowException(v8::Exception::TypeError(
+        v8::String::New(message.c_str())));
+}
+
+bool IsInteger(v8::Handle<v8::Value> value, double minimum, double maximum) {
+  if (!value->IsNumber()) {
+    return false;
+  }
+  double number = value->NumberValue();
+  return number >= minimum && number <= maximum
+    && std::floor(number) == number;
+}
+
+} // namespace binding
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,421 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Generates V8 callbacks from C++ member function signatures
+ *
+ * A native method is written as an ordinary member function taking C++
+ * arguments, e.g.,
+ *
+ *   v8::Handle<v8::Value> Seek(off_t offset, int whence);
+ *
+ * and bound with
+ *
+ *   binding::Method2<Stream, off_t, int, &Stream::Seek, 1>::Call
+ *
+ * The generated callback fetches the native object from internal field 0
+ * once, checks the argument count and the type of every argument, throws
+ * a TypeError naming the offending argument if a check fails, converts
+ * the arguments and calls the member function. Trailing arguments beyond
+ * the required count are optional, missing arguments are passed as a
+ * value-initialized T(), i.e., zero or false.
+ *
+ * Argument<T> defines the accepted JavaScript values for each parameter
+ * type. 64-bit integer types accept any integral number a double holds
+ * exactly, i.e., up to 2^53 in magnitude.
+ */
+
+#ifndef MOKA_BINDING_H
+#define MOKA_BINDING_H
+
+#include <climits>
+#include <moka/macros.h>
+#include <v8.h>
+
+namespace moka {
+
+namespace binding {
+
+template<typename T> struct Argument;
+
+template<> struct Argument<int>;
+
+template<> struct Argument<unsigned int>;
+
+template<> struct Argument<long>;
+
+template<> struct Argument<unsigned long>;
+
+template<> struct Argument<long long>;
+
+template<> struct Argument<unsigned long long>;
+
+template<> struct Argument<double>;
+
+template<> struct Argument<bool>;
+
+template<> struct Argument<v8::Handle<v8::Value> >;
+
+template<> struct Argument<v8::Handle<v8::Object> >;
+
+template<typename C, v8::Handle<v8::Value> (C::*M)()> struct Method0;
+
+template<typename C, typename A1, v8::Handle<v8::Value> (C::*M)(A1),
+  int R = 1> struct Method1;
+
+template<typename C, typename A1, typename A2,
+  v8::Handle<v8::Value> (C::*M)(A1, A2), int R = 2> struct Method2;
+
+template<typename C, typename A1, typename A2, typename A3,
+  v8::Handle<v8::Value> (C::*M)(A1, A2, A3), int R = 3> struct Method3;
+
+/**
+ * \brief Throw a TypeError for a wrong number of arguments
+ *
+ * \param required [in] The number of required arguments
+ * \param arity [in] The number of accepted arguments
+ *
+ * \return The thrown exception.
+ */
+MOKA_EXPORT v8::Handle<v8::Value> ThrowArityError(int required, int arity);
+
+/**
+ * \brief Throw a TypeError for an argument of the wrong type
+ *
+ * \param index [in] The zero-based argument index
+ * \param type [in] The expected type, e.g., "an unsigned long"
+ *
+ * \return The thrown exception.
+ */
+MOKA_EXPORT v8::Handle<v8::Value> ThrowTypeError(int index, const char* type);
+
+/// \brief The largest integer a number represents exactly, i.e., 2^53
+const double kMaxInteger = 9007199254740992.0;
+
+/**
+ * \brief Check for an integral number
+ *
+ * \param value [in] The value to check
+ * \param minimum [in] The smallest accepted integer
+ * \param maximum [in] The largest accepted integer
+ *
+ * \return This function returns true if value is a number without a
+ *         fractional part in the range [minimum, maximum], false
+ *         otherwise.
+ */
+MOKA_EXPORT bool IsInteger(v8::Handle<v8::Value> value, double minimum,
+    double maximum);
+
+/**
+ * \brief Get the native object of a method call
+ *
+ * \param arguments [in] The arguments of a method call
+ *
+ * \return The object stored in internal field 0 of the receiver.
+ */
+template<typename C>
+inline C* Self(const v8::Arguments& arguments) {
+  return static_cast<C*>(arguments.This()->GetPointerFromInternalField(0));
+}
+
+/**
+ * \brief Check and convert argument index
+ *
+ * \param arguments [in] The arguments of a method call
+ * \param index [in] The zero-based argument index
+ * \param value [out] The converted argument, unchanged if the argument is
+ *                    missing
+ *
+ * \return This function returns false if the argument has the wrong
+ *         type (an exception has been thrown), true otherwise.
+ */
+template<typename T>
+inline bool Unpack(const v8::Arguments& arguments, int index, T* value) {
+  if (index >= arguments.Length()) {
+    return true;
+  }
+  if (!Argument<T>::Is(arguments[index])) {
+    ThrowTypeError(index, Argument<T>::Name());
+    return false;
+  }
+  *value = Argument<T>::Get(arguments[index]);
+  return true;
+}
+
+} // namespace binding
+
+} // namespace moka
+
+/// \brief Accepts a long (32-bit signed integer)
+template<>
+struct moka::binding::Argument<int> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return value->IsInt32();
+  }
+
+  static int Get(v8::Handle<v8::Value> value) {
+    return value->Int32Value();
+  }
+
+  static const char* Name() {
+    return "a long";
+  }
+};
+
+/// \brief Accepts an unsigned long (32-bit unsigned integer)
+template<>
+struct moka::binding::Argument<unsigned int> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return value->IsUint32();
+  }
+
+  static unsigned int Get(v8::Handle<v8::Value> value) {
+    return value->Uint32Value();
+  }
+
+  static const char* Name() {
+    return "an unsigned long";
+  }
+};
+
+/// \brief Accepts a long long where long is 64 bits, e.g., an off_t
+template<>
+struct moka::binding::Argument<long> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return IsInteger(value, LONG_MIN > -kMaxInteger ? LONG_MIN : -kMaxInteger,
+        LONG_MAX < kMaxInteger ? LONG_MAX : kMaxInteger);
+  }
+
+  static long Get(v8::Handle<v8::Value> value) {
+    return static_cast<long>(value->IntegerValue());
+  }
+
+  static const char* Name() {
+    return LONG_MAX > INT_MAX ? "a long long" : "a long";
+  }
+};
+
+/// \brief Accepts an unsigned long long where long is 64 bits, e.g., a
+///        size_t
+template<>
+struct moka::binding::Argument<unsigned long> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return IsInteger(value, 0,
+        ULONG_MAX < kMaxInteger ? ULONG_MAX : kMaxInteger);
+  }
+
+  static unsigned long Get(v8::Handle<v8::Value> value) {
+    return static_cast<unsigned long>(value->IntegerValue());
+  }
+
+  static const char* Name() {
+    return ULONG_MAX > UINT_MAX
+      ? "an unsigned long long" : "an unsigned long";
+  }
+};
+
+/// \brief Accepts a long long, e.g., a 64-bit off_t
+template<>
+struct moka::binding::Argument<long long> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return IsInteger(value, -kMaxInteger, kMaxInteger);
+  }
+
+  static long long Get(v8::Handle<v8::Value> value) {
+    return value->IntegerValue();
+  }
+
+  static const char* Name() {
+    return "a long long";
+  }
+};
+
+/// \brief Accepts an unsigned long long, e.g., a 64-bit byte length
+template<>
+struct moka::binding::Argument<unsigned long long> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return IsInteger(value, 0, kMaxInteger);
+  }
+
+  static unsigned long long Get(v8::Handle<v8::Value> value) {
+    return value->IntegerValue();
+  }
+
+  static const char* Name() {
+    return "an unsigned long long";
+  }
+};
+
+/// \brief Accepts any number
+template<>
+struct moka::binding::Argument<double> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return value->IsNumber();
+  }
+
+  static double Get(v8::Handle<v8::Value> value) {
+    return value->NumberValue();
+  }
+
+  static const char* Name() {
+    return "a number";
+  }
+};
+
+/// \brief Accepts any value, converted with ToBoolean
+template<>
+struct moka::binding::Argument<bool> {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return true;
+  }
+
+  static bool Get(v8::Handle<v8::Value> value) {
+    return value->BooleanValue();
+  }
+
+  static const char* Name() {
+    return "a boolean";
+  }
+};
+
+/// \brief Accepts any value
+template<>
+struct moka::binding::Argument<v8::Handle<v8::Value> > {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return true;
+  }
+
+  static v8::Handle<v8::Value> Get(v8::Handle<v8::Value> value) {
+    return value;
+  }
+
+  static const char* Name() {
+    return "a value";
+  }
+};
+
+/// \brief Accepts an object
+template<>
+struct moka::binding::Argument<v8::Handle<v8::Object> > {
+  static bool Is(v8::Handle<v8::Value> value) {
+    return value->IsObject();
+  }
+
+  static v8::Handle<v8::Object> Get(v8::Handle<v8::Value> value) {
+    return v8::Handle<v8::Object>::Cast(value);
+  }
+
+  static const char* Name() {
+    return "an object";
+  }
+};
+
+/// \brief Binds a member function taking no arguments
+template<typename C, v8::Handle<v8::Value> (C::*M)()>
+struct moka::binding::Method0 {
+  static v8::Handle<v8::Value> Invoke(C* self,
+      const v8::Arguments& arguments) {
+    if (arguments.Length()) {
+      return ThrowArityError(0, 0);
+    }
+    return (self->*M)();
+  }
+
+  static v8::Handle<v8::Value> Call(const v8::Arguments& arguments) {
+    return Invoke(Self<C>(arguments), arguments);
+  }
+};
+
+/// \brief Binds a member function taking one argument
+template<typename C, typename A1, v8::Handle<v8::Value> (C::*M)(A1), int R>
+struct moka::binding::Method1 {
+  static v8::Handle<v8::Value> Invoke(C* self,
+      const v8::Arguments& arguments) {
+    if (arguments.Length() < R || arguments.Length() > 1) {
+      return ThrowArityError(R, 1);
+    }
+    A1 a1 = A1();
+    if (!Unpack(arguments, 0, &a1)) {
+      return v8::Handle<v8::Value>();
+    }
+    return (self->*M)(a1);
+  }
+
+  static v8::Handle<v8::Value> Call(const v8::Arguments& arguments) {
+    return Invoke(Self<C>(arguments), arguments);
+  }
+};
+
+/// \brief Binds a member function taking two arguments
+template<typename C, typename A1, typename A2,
+  v8::Handle<v8::Value> (C::*M)(A1, A2), int R>
+struct moka::binding::Method2 {
+  static v8::Handle<v8::Value> Invoke(C* self,
+      const v8::Arguments& arguments) {
+    if (arguments.Length() < R || arguments.Length() > 2) {
+      return ThrowArityError(R, 2);
+    }
+    A1 a1 = A1();
+    A2 a2 = A2();
+    if (!Unpack(arguments, 0, &a1) || !Unpack(arguments, 1, &a2)) {
+      return v8::Handle<v8::Value>();
+    }
+    return (self->*M)(a1, a2);
+  }
+
+  static v8::Handle<v8::Value> Call(const v8::Arguments& arguments) {
+    return Invoke(Self<C>(arguments), arguments);
+  }
+};
+
+/// \brief Binds a member function taking three arguments
+template<typename C, typename A1, typename A2, typename A3,
+  v8::Handle<v8::Value> (C::*M)(A1, A2, A3), int R>
+struct moka::binding::Method3 {
+  static v8::Handle<v8::Value> Invoke(C* self,
+      const v8::Arguments& arguments) {
+    if (arguments.Length() < R || arguments.Length() > 3) {
+      return ThrowArityError(R, 3);
+    }
+    A1 a1 = A1();
+    A2 a2 = A2();
+    A3 a3 = A3();
+    if (!Unpack(arguments, 0, &a1) || !Unpack(arguments, 1, &a2)
+        || !Unpack(arguments, 2, &a3)) {
+      return v8::Handle<v8::Value>();
+    }
+    return (self->*M)(a1, a2, a3);
+  }
+
+  static v8::Handle<v8::Value> Call(const v8::Arguments& arguments) {
+    return Invoke(Self<C>(arguments), arguments);
+  }
+};
+
+#endif // MOKA_BINDING_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,238 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/buffer-pool.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include "moka/buffer-pool.h"
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+namespace moka {
+
+namespace internal {
+
+static const size_t kAlignment = 64;
+
+static const size_t kMinimumSize = 16;
+
+// 16 B, 32 B, ..., 64 KiB
+static const size_t kClassCount = 13;
+
+static const size_t kMaximumPooled = 1024 * 1024;
+
+static const size_t kMapThreshold = 1024 * 1024;
+
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+// A store on a free list
+struct FreeStore {
+  FreeStore* next;
+  // Bytes from the start of the store that may be non-zero
+  size_t dirty;
+};
+
+static __thread FreeStore* free_lists[kClassCount];
+
+static __thread size_t pooled_bytes[kClassCount];
+
+static enum {
+  kUnset,
+  kDisabled,
+  kEnabled
+} state = kUnset;
+
+static bool Enabled() {
+  if (kUnset == state) {
+    state = kDisabled;
+  }
+  return kEnabled == state;
+}
+
+static bool huge_pages = false;
+
+// Mapped stores and their mapped lengths
+typedef std::map<void*, size_t> MappingMap;
+
+static MappingMap mappings;
+
+static pthread_mutex_t mappings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t RoundUp(size_t length, size_t alignment) {
+  return (length + alignment - 1) / alignment * alignment;
+}
+
+// Map a store of at least kMapThreshold bytes
+static void* Map(size_t length) {
+  size_t page_size = ::sysconf(_SC_PAGESIZE);
+  size_t size = RoundUp(length, page_size);
+  bool huge = huge_pages && size >= kHugePageSize;
+  // Over-allocate so the store can be aligned to a huge page
+  size_t mapped = huge ? size + kHugePageSize - page_size : size;
+  void* address = ::mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == address) {
+    return NULL;
+  }
+  char* store = static_cast<char*>(address);
+  if (huge) {
+    char* aligned = reinterpret_cast<char*>(RoundUp(
+          reinterpret_cast<size_t>(store), kHugePageSize));
+    if (aligned != store) {
+      ::munmap(store, aligned - store);
+    }
+    if (aligned + size != store + mapped) {
+      ::munmap(aligned + size, store + mapped - aligned - size);
+    }
+    store = aligned;
+#ifdef MADV_HUGEPAGE
+    ::madvise(store, size, MADV_HUGEPAGE);
+#endif
+  }
+  ::pthread_mutex_lock(&mappings_mutex);
+  mappings[store] = size;
+  ::pthread_mutex_unlock(&mappings_mutex);
+  return store;
+}
+
+static void Unmap(void* store) {
+  ::pthread_mutex_lock(&mappings_mutex);
+  MappingMap::iterator iter = mappings.find(store);
+  size_t size = iter->second;
+  mappings.erase(iter);
+  ::pthread_mutex_unlock(&mappings_mutex);
+  ::munmap(store, size);
+}
+
+// Get the size class of length, kClassCount if it is not pooled
+static size_t GetClass(size_t length) {
+  size_t index = 0;
+  for (size_t size = kMinimumSize; size < length; size <<= 1) {
+    if (++index == kClassCount) {
+      break;
+    }
+  }
+  return index;
+}
+
+bool BufferPool::SetEnabled(bool enabled) {
+  if (kUnset != state) {
+    return (kEnabled == state) == enabled;
+  }
+  state = enabled ? kEnabled : kDisabled;
+  return true;
+}
+
+void BufferPool::SetHugePages(bool enabled) {
+  huge_pages = enabled;
+}
+
+void* BufferPool::Allocate(size_t length) {
+  if (length >= kMapThreshold) {
+    // Anonymous pages are zero and cost nothing until they are touched
+    return Map(length);
+  }
+  if (!Enabled()) {
+    return ::calloc(length, sizeof(char));
+  }
+  size_t index = GetClass(length);
+  if (index < kClassCount && free_lists[index]) {
+    FreeStore* store = free_lists[index];
+    free_lists[index] = store->next;
+    pooled_bytes[index] -= kMinimumSize << index;
+    ::memset(store, 0, store->dirty);
+    return store;
+  }
+  size_t size = index < kClassCount ? kMinimumSize << index : length;
+  void* store;
+  int error = ::posix_memalign(&store, kAlignment, size);
+  if (error) {
+    // posix_memalign() returns the error instead of setting errno
+    errno = error;
+    return NULL;
+  }
+  ::memset(store, 0, size);
+  return store;
+}
+
+void BufferPool::Free(void* store, size_t length) {
+  if (!store) {
+    return;
+  }
+  if (length >= kMapThreshold) {
+    Unmap(store);
+    return;
+  }
+  size_t index = Enabled() ? GetClass(length) : kClassCount;
+  if (index == kClassCount
+      || pooled_bytes[index] + (kMinimumSize << index) > kMaximumPooled) {
+    ::free(store);
+    return;
+  }
+  FreeStore* head = static_cast<FreeStore*>(store);
+  head->next = free_lists[index];
+  head->dirty = length > sizeof(FreeStore) ? length : sizeof(FreeStore);
+  free_lists[index] = head;
+  pooled_bytes[index] += kMinimumSize << index;
+}
+
+void BufferPool::GetMappedStats(size_t* mapped, size_t* resident) {
+  *mapped = *resident = 0;
+  size_t page_size = ::sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> pages;
+  ::pthread_mutex_lock(&mappings_mutex);
+  for (MappingMap::iterator iter = mappings.begin(); iter != mappings.end();
+      ++iter) {
+    *mapped += (*iter).second;
+    pages.resize((*iter).second / page_size);
+    if (pages.empty()
+        || ::mincore((*iter).first, (*iter).second, &pages[0])) {
+      continue;
+    }
+    for (size_t index = 0; index < pages.size(); ++index) {
+      if (pages[index] & 1) {
+        *resident += page_size;
+      }
+    }
+  }
+  ::pthread_mutex_unlock(&mappings_mutex);
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
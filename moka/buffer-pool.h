@@ -0,0 +1,124 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief A pool of ArrayBuffer backing stores
+ */
+
+#ifndef MOKA_BUFFER_POOL_H
+#define MOKA_BUFFER_POOL_H
+
+#include <cstddef>
+
+namespace moka {
+
+namespace internal {
+
+class BufferPool;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief Allocates zeroed, 64-byte aligned backing stores
+ *
+ * Stores of 16 B to 64 KiB are rounded up to a power of two and recycled
+ * through per-thread free lists, one per size class. A recycled store is
+ * zeroed only up to the length its previous owner could write to, the
+ * rest of the store is known to be zero. Each free list keeps at most
+ * 1 MiB, stores beyond that are returned to the system.
+ *
+ * The pool is disabled by default, stores are then allocated with
+ * calloc(). Whether the pool is used is latched by the first allocation.
+ *
+ * Stores of 1 MiB and more are always mapped anonymously with mmap(), so
+ * pages that are never touched cost nothing, and unmapped when they are
+ * freed. Mappings of 2 MiB and more may be backed by transparent huge
+ * pages (see SetHugePages()).
+ */
+class moka::internal::BufferPool {
+public:
+  /**
+   * \brief Enable or disable the pool
+   *
+   * \param enabled [in] True to recycle stores through the pool
+   *
+   * \return This function returns false if a store has already been
+   *         allocated and the setting can not be changed, true otherwise.
+   */
+  static bool SetEnabled(bool enabled);
+
+  /**
+   * \brief Advise the kernel to back large stores with huge pages
+   *
+   * This reduces TLB misses on large, densely used stores at the cost of
+   * making every touched huge page resident in full. Disabled by default.
+   *
+   * \param enabled [in] True to call madvise(MADV_HUGEPAGE) on stores of
+   *                     2 MiB and more
+   */
+  static void SetHugePages(bool enabled);
+
+  /**
+   * \brief Allocate a zeroed store
+   *
+   * \param length [in] The length of the store in bytes (non-zero)
+   *
+   * \return A pointer to the store or NULL if memory is exhausted, in
+   *         which case errno is set.
+   */
+  static void* Allocate(size_t length);
+
+  /**
+   * \brief Free a store
+   *
+   * \param store [in] A store returned by Allocate() or NULL
+   * \param length [in] The length that was passed to Allocate()
+   */
+  static void Free(void* store, size_t length);
+
+  /**
+   * \brief Get the memory use of mapped stores
+   *
+   * \param mapped [out] The number of bytes mapped for live stores
+   * \param resident [out] The number of those bytes that are resident,
+   *                       as reported by mincore()
+   */
+  static void GetMappedStats(size_t* mapped, size_t* resident);
+
+private: // non-copyable
+  BufferPool();
+
+  BufferPool(BufferPool const& that);
+
+  void operator=(BufferPool const& that);
+};
+
+#endif // MOKA_BUFFER_POOL_H
+
+// vim: tabstop=2:sw=2:expandtab
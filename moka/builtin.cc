@@ -0,0 +1,73 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/builtin.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "moka/builtin.h"
+#include <tr1/unordered_map>
+
+namespace moka {
+
+namespace internal {
+
+typedef std::tr1::unordered_map<std::string, const module*> BuiltinMap;
+
+/**
+ * \brief Get the registry
+ *
+ * The registry is created on first use so modules may register from
+ * static initializers in any translation unit.
+ *
+ * \return The built-in module registry.
+ */
+static BuiltinMap& GetRegistry() {
+  static BuiltinMap registry;
+  return registry;
+}
+
+bool Builtin::Register(const char* id, const module* init) {
+  return GetRegistry().insert(BuiltinMap::value_type(id, init)).second;
+}
+
+const module* Builtin::Find(const std::string& id) {
+  BuiltinMap& registry = GetRegistry();
+  BuiltinMap::const_iterator iter = registry.find(id);
+  if (registry.end() != iter) {
+    return (*iter).second;
+  }
+  return NULL;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
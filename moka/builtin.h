@@ -0,0 +1,106 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief A registry of native modules linked into the Moka library
+ */
+
+#ifndef MOKA_BUILTIN_H
+#define MOKA_BUILTIN_H
+
+#include "moka/module.h"
+#include <string>
+
+namespace moka {
+
+namespace internal {
+
+class Builtin;
+
+} // namespace internal
+
+} // namespace moka
+
+/// \brief The built-in module registry
+class moka::internal::Builtin {
+public:
+  /**
+   * \brief Register a built-in module
+   *
+   * This function is usually called by MOKA_BUILTIN_MODULE() during
+   * static initialization.
+   *
+   * \param id [in] The top-level module ID, e.g., "io"
+   * \param init [in] The module initialization structure
+   *
+   * \return This function returns true if the module was registered,
+   *         false if a module with the same ID is already registered.
+   */
+  static bool Register(const char* id, const module* init);
+
+  /**
+   * \brief Find a built-in module
+   *
+   * \param id [in] A top-level module ID
+   *
+   * \return The initialization structure of the module or NULL if there
+   *         is no built-in module named id.
+   */
+  static const module* Find(const std::string& id);
+
+private: // non-instantiable
+  Builtin();
+
+  Builtin(Builtin const& that);
+
+  void operator=(Builtin const& that);
+};
+
+/**
+ * \brief Helper macro for built-in module implementations
+ *
+ * This macro is the built-in counterpart of MOKA_MODULE(). Instead of
+ * exporting a moka_module__ structure it registers the module with the
+ * built-in module registry during static initialization. A built-in
+ * module is found without searching 'require.paths'.
+ *
+ * \param id [in] The top-level module ID (a string literal)
+ * \param initialize [in] A pointer to the module initialization function
+ */
+#define MOKA_BUILTIN_MODULE(id, initialize) \
+static const moka::module moka_builtin_module__ = { \
+  MOKA_MODULE_VERSION_MAJOR, \
+  MOKA_MODULE_VERSION_MINOR, \
+  initialize, \
+}; \
+static const bool moka_builtin_registered__ \
+  __attribute__ ((unused)) = \
+  moka::internal::Builtin::Register(id, &moka_builtin_module__);
+
+#endif // MOKA_BUILTIN_H
+
+// vim: tabstop=2:sw=2:expandtab
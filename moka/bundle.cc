@@ -0,0 +1,214 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/bundle.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include "moka/bundle.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace moka {
+
+namespace internal {
+
+class BundleString;
+
+} // namespace internal
+
+} // namespace moka
+
+/// \brief An external string referencing a bundle
+class moka::internal::BundleString:
+  public v8::String::ExternalAsciiStringResource {
+public:
+  BundleString(BundlePointer bundle, const char* data, size_t length)
+    : bundle_(bundle)
+    , data_(data)
+    , length_(length) {}
+
+  virtual ~BundleString() {}
+
+  virtual const char* data() const {
+    return data_;
+  }
+
+  virtual size_t length() const {
+    return length_;
+  }
+
+private: // non-copyable
+  BundleString(BundleString const& that);
+
+  void operator=(BundleString const& that);
+
+private: // private data
+  BundlePointer bundle_;
+  const char* data_;
+  size_t length_;
+};
+
+namespace moka {
+
+namespace internal {
+
+BundlePointer Bundle::Open(const char* file_name) {
+  BundlePointer bundle;
+  char resolved_path[PATH_MAX];
+  if (!realpath(file_name, resolved_path)) {
+    return bundle;
+  }
+  int fd = ::open(resolved_path, O_RDONLY);
+  if (-1 == fd) {
+    return bundle;
+  }
+  struct stat buf;
+  if (::fstat(fd, &buf)) {
+    ::close(fd);
+    return bundle;
+  }
+  if (!S_ISREG(buf.st_mode)
+      || static_cast<size_t>(buf.st_size) < sizeof(BundleHeader)) {
+    ::close(fd);
+    errno = EINVAL;
+    return bundle;
+  }
+  // Map the whole bundle, the descriptor is not needed afterwards
+  void* address = ::mmap(NULL, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (MAP_FAILED == address) {
+    return bundle;
+  }
+  bundle.reset(new Bundle(resolved_path, address, buf.st_size,
+        buf.st_mtime));
+  if (!bundle.get()) {
+    ::munmap(address, buf.st_size);
+    errno = ENOMEM;
+    return bundle;
+  }
+  if (!bundle->ReadIndex()) {
+    bundle.reset();
+    errno = EINVAL;
+  }
+  return bundle;
+}
+
+uint32_t Bundle::Hash(const char* data, size_t length) {
+  uint32_t hash = 2166136261U;
+  for (size_t index = 0; index < length; ++index) {
+    hash ^= static_cast<unsigned char>(data[index]);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+Bundle::~Bundle() {
+  ::munmap(address_, length_);
+}
+
+bool Bundle::ReadIndex() {
+  const BundleHeader* header = static_cast<const BundleHeader*>(address_);
+  if (::memcmp(header->magic, kBundleMagic, sizeof(kBundleMagic))
+      || kBundleVersion != header->version) {
+    return false;
+  }
+  // Verify that the index and the string table are within the bundle
+  if (header->count > (length_ - sizeof(BundleHeader)) / sizeof(BundleEntry)
+      || header->strings_offset > length_
+      || header->strings_length > length_ - header->strings_offset) {
+    return false;
+  }
+  const BundleEntry* entries =
+    reinterpret_cast<const BundleEntry*>(header + 1);
+  for (uint32_t index = 0; index < header->count; ++index) {
+    const BundleEntry* entry = entries + index;
+    if (entry->id_offset > header->strings_length
+        || entry->id_length > header->strings_length - entry->id_offset
+        || entry->source_offset > length_
+        || entry->source_length > length_ - entry->source_offset
+        || entry->source_length > INT_MAX
+        || entry->cache_offset > length_
+        || entry->cache_length > length_ - entry->cache_offset
+        || entry->cache_length > INT_MAX) {
+      return false;
+    }
+    std::string id(GetData(header->strings_offset + entry->id_offset),
+        entry->id_length);
+    entries_.insert(EntryMap::value_type(id, entry));
+  }
+  return true;
+}
+
+v8::Local<v8::String> BundleSource::NewString() {
+  const char* data = bundle_->GetData(entry_->source_offset);
+  size_t length = entry_->source_length;
+  if (entry_->hash != Bundle::Hash(data, length)) {
+    errno = EILSEQ;
+    return v8::Local<v8::String>();
+  }
+  if (!length) {
+    return v8::String::Empty();
+  }
+  if (entry_->flags & kBundleAscii) {
+    BundleString* resource = new BundleString(bundle_, data, length);
+    if (!resource) {
+      errno = ENOMEM;
+      return v8::Local<v8::String>();
+    }
+    return v8::String::NewExternal(resource);
+  }
+  return v8::String::New(data, length);
+}
+
+v8::ScriptData* BundleSource::NewScriptData() {
+  if (!entry_->cache_length) {
+    return NULL;
+  }
+  v8::ScriptData* data = v8::ScriptData::New(
+      bundle_->GetData(entry_->cache_offset), entry_->cache_length);
+  if (!data || data->HasError()) {
+    delete data;
+    return NULL;
+  }
+  return data;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,257 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Many script modules packed into a single file
+ *
+ * A bundle starts with a header followed by an index of entries, one per
+ * module, sorted by module ID. Each entry locates the module ID in the
+ * string table and the source (and optionally pre-compilation data) in
+ * the data section. All offsets are relative to the start of the file.
+ * Bundles use the byte order of the host that created them, a bundle
+ * with a different byte order is rejected because the version does not
+ * match.
+ */
+
+#ifndef MOKA_BUNDLE_H
+#define MOKA_BUNDLE_H
+
+#include <cstddef>
+#include <ctime>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include "moka/script-source.h"
+#include <tr1/memory>
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+class Bundle;
+class BundleSource;
+struct BundleEntry;
+struct BundleHeader;
+
+typedef std::tr1::shared_ptr<Bundle> BundlePointer;
+
+/// \brief Identifies a bundle file
+const char kBundleMagic[8] = { 'M', 'O', 'K', 'A', 'B', 'N', 'D', 'L' };
+
+/// \brief The bundle format version
+const uint32_t kBundleVersion = 1;
+
+/// \brief The entry source contains only 7-bit ASCII characters
+const uint32_t kBundleAscii = 0x1;
+
+} // namespace internal
+
+} // namespace moka
+
+/// \brief The bundle file header
+struct moka::internal::BundleHeader {
+  /// \brief Always "MOKABNDL"
+  char magic[8];
+  /// \brief The format version
+  uint32_t version;
+  /// \brief The number of entries in the index
+  uint32_t count;
+  /// \brief The offset of the string table
+  uint64_t strings_offset;
+  /// \brief The length of the string table
+  uint64_t strings_length;
+};
+
+/// \brief A bundle index entry
+struct moka::internal::BundleEntry {
+  /// \brief The offset of the module source
+  uint64_t source_offset;
+  /// \brief The length of the module source
+  uint64_t source_length;
+  /// \brief The offset of the pre-compilation data, may be zero
+  uint64_t cache_offset;
+  /// \brief The length of the pre-compilation data, may be zero
+  uint64_t cache_length;
+  /// \brief The offset of the module ID in the string table
+  uint32_t id_offset;
+  /// \brief The length of the module ID
+  uint32_t id_length;
+  /// \brief The 32-bit FNV-1a hash of the source
+  uint32_t hash;
+  /// \brief Entry flags, e.g., kBundleAscii
+  uint32_t flags;
+};
+
+/// \brief A read-only, memory mapped module bundle
+class moka::internal::Bundle {
+public:
+  /**
+   * \brief Open a bundle
+   *
+   * The entire file is mapped once and the index is validated.
+   *
+   * \param file_name [in] The file name of the bundle
+   *
+   * \return A new bundle. If the bundle could not be opened NULL is
+   *         returned and errno is set. The return value can be checked
+   *         with std::tr1::shared_ptr::get().
+   */
+  static BundlePointer Open(const char* file_name);
+
+  /**
+   * \brief Compute the hash stored in a bundle entry
+   *
+   * \param data [in] The source
+   * \param length [in] The length of data in bytes
+   *
+   * \return The 32-bit FNV-1a hash of data.
+   */
+  static uint32_t Hash(const char* data, size_t length);
+
+  /// \brief Unmaps the bundle
+  ~Bundle();
+
+  /**
+   * \brief Find a module in the bundle
+   *
+   * \param id [in] A normalized module ID, e.g., "foo/bar"
+   *
+   * \return The index entry for id or NULL if id is not in the bundle.
+   */
+  const BundleEntry* Find(const std::string& id) const {
+    EntryMap::const_iterator iter = entries_.find(id);
+    if (entries_.end() != iter) {
+      return (*iter).second;
+    }
+    return NULL;
+  }
+
+  /**
+   * \brief Get the resolved path of the bundle
+   *
+   * Modules in the bundle are named as if the bundle were a directory,
+   * e.g., the module "foo/bar" is named "/path/to/bundle/foo/bar.js".
+   *
+   * \return The absolute path of the bundle file.
+   */
+  const char* GetFileName() const {
+    return file_name_.c_str();
+  }
+
+  /**
+   * \brief Get the modification time of the bundle
+   *
+   * \return The modification time of the bundle file.
+   */
+  time_t GetMtime() const {
+    return mtime_;
+  }
+
+  /**
+   * \brief Get a pointer into the bundle
+   *
+   * \param offset [in] An offset from an index entry
+   *
+   * \return A pointer to offset bytes from the start of the bundle.
+   */
+  const char* GetData(uint64_t offset) const {
+    return static_cast<const char*>(address_) + offset;
+  }
+
+private: // non-copyable
+  Bundle(Bundle const& that);
+
+  void operator=(Bundle const& that);
+
+private: // private methods
+  typedef std::map<std::string, const BundleEntry*> EntryMap;
+
+  Bundle(const char* file_name, void* address, size_t length, time_t mtime)
+    : file_name_(file_name)
+    , address_(address)
+    , length_(length)
+    , mtime_(mtime) {}
+
+  bool ReadIndex();
+
+private: // private data
+  std::string file_name_;
+  void* address_;
+  size_t length_;
+  time_t mtime_;
+  EntryMap entries_;
+};
+
+/// \brief A script read from a bundle
+class moka::internal::BundleSource: public moka::internal::ScriptSource {
+public:
+  /**
+   * \brief Construct a source from a bundle entry
+   *
+   * \param bundle [in] The bundle containing entry
+   * \param entry [in] An entry returned by Bundle::Find()
+   */
+  BundleSource(BundlePointer bundle, const BundleEntry* entry)
+    : bundle_(bundle)
+    , entry_(entry) {}
+
+  /// \brief Destructor
+  virtual ~BundleSource() {}
+
+  /**
+   * \brief Create a string that references the bundle
+   *
+   * ASCII sources are handed to V8 as external strings that keep the
+   * bundle mapped. If the source does not match the hash in the index
+   * an empty handle is returned and errno is set to EILSEQ.
+   */
+  virtual v8::Local<v8::String> NewString();
+
+  virtual time_t GetMtime() const {
+    return bundle_->GetMtime();
+  }
+
+  virtual size_t GetSize() const {
+    return entry_->source_length;
+  }
+
+  virtual v8::ScriptData* NewScriptData();
+
+private: // non-copyable
+  BundleSource(BundleSource const& that);
+
+  void operator=(BundleSource const& that);
+
+private: // private data
+  BundlePointer bundle_;
+  const BundleEntry* entry_;
+};
+
+#endif // MOKA_BUNDLE_H
+
+// vim: tabstop=2:sw=2:expandtab
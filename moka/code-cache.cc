@@ -0,0 +1,229 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/code-cache.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "moka/code-cache.h"
+#include <sstream>
+#include <unistd.h>
+
+namespace moka {
+
+namespace internal {
+
+/// \brief Identifies a cache entry file (and its format version)
+static const char kMagic[8] = { 'M', 'O', 'K', 'A', 'C', 'C', '0', '1' };
+
+CodeCache::CodeCache(const char* directory)
+  : directory_(directory ? directory : "")
+  , version_(v8::V8::GetVersion())
+  , hits_(0)
+  , misses_(0) {
+  ::pthread_mutex_init(&mutex_, NULL);
+}
+
+CodeCache::~CodeCache() {
+  ::pthread_mutex_destroy(&mutex_);
+}
+
+v8::Local<v8::Script> CodeCache::Compile(v8::Handle<v8::String> source,
+    const char* file_name, time_t mtime, off_t size, bool wrapped) {
+  v8::ScriptOrigin origin(v8::String::New(file_name));
+  if (directory_.empty()) {
+    // Caching is disabled
+    return v8::Script::Compile(source, &origin);
+  }
+  std::string key(GetKey(file_name, mtime, size, wrapped));
+  std::string entry_name(GetEntryName(key));
+  // Attempt to compile from a prefetched or an existing entry, V8 may
+  // reference (not copy) the entry data
+  std::string entry;
+  bool found = false;
+  ::pthread_mutex_lock(&mutex_);
+  PrefetchMap::iterator iter = prefetched_.find(entry_name);
+  if (prefetched_.end() != iter) {
+    entry.swap((*iter).second);
+    prefetched_.erase(iter);
+    found = true;
+  }
+  ::pthread_mutex_unlock(&mutex_);
+  if (!found) {
+    found = ReadEntry(entry_name, key, &entry);
+  }
+  v8::ScriptData* data = NULL;
+  if (found) {
+    data = v8::ScriptData::New(entry.data(), entry.length());
+    if (data && !data->HasError()) {
+      v8::Local<v8::Script> script =
+        v8::Script::Compile(source, &origin, data);
+      delete data;
+      ++hits_;
+      return script;
+    }
+    delete data;
+  }
+  ++misses_;
+  // Pre-compile the source and store a new entry
+  data = v8::ScriptData::PreCompile(source);
+  if (!data) {
+    return v8::Script::Compile(source, &origin);
+  }
+  if (data->HasError()) {
+    // Let the compiler report the error
+    delete data;
+    return v8::Script::Compile(source, &origin);
+  }
+  WriteEntry(entry_name, key, data);
+  v8::Local<v8::Script> script = v8::Script::Compile(source, &origin, data);
+  delete data;
+  return script;
+}
+
+void CodeCache::Prefetch(const char* file_name, time_t mtime, off_t size,
+    bool wrapped) {
+  if (directory_.empty()) {
+    return;
+  }
+  std::string key(GetKey(file_name, mtime, size, wrapped));
+  std::string entry_name(GetEntryName(key));
+  std::string entry;
+  if (!ReadEntry(entry_name, key, &entry)) {
+    return;
+  }
+  ::pthread_mutex_lock(&mutex_);
+  prefetched_[entry_name].swap(entry);
+  ::pthread_mutex_unlock(&mutex_);
+}
+
+std::string CodeCache::GetKey(const char* file_name, time_t mtime,
+    off_t size, bool wrapped) const {
+  std::stringstream key;
+  key << file_name << '\n' << mtime << '\n' << size << '\n'
+    << (wrapped ? "wrapped" : "program") << '\n' << version_;
+  return key.str();
+}
+
+std::string CodeCache::GetEntryName(const std::string& key) const {
+  // 64-bit FNV-1a hash of the key
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::string::size_type index = 0; index < key.length(); ++index) {
+    hash ^= static_cast<unsigned char>(key[index]);
+    hash *= 1099511628211ULL;
+  }
+  char name[17];
+  ::snprintf(name, sizeof(name), "%016llx",
+      static_cast<unsigned long long>(hash));
+  std::string entry_name(directory_);
+  entry_name.append("/");
+  entry_name.append(name);
+  entry_name.append(".cache");
+  return entry_name;
+}
+
+bool CodeCache::ReadEntry(const std::string& entry_name,
+    const std::string& key, std::string* data) const {
+  FILE* file = ::fopen(entry_name.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  // Verify the header and the key, a mismatch is a hash collision
+  char magic[sizeof(kMagic)];
+  uint32_t length;
+  if (1 != ::fread(magic, sizeof(magic), 1, file)
+      || ::memcmp(magic, kMagic, sizeof(kMagic))
+      || 1 != ::fread(&length, sizeof(length), 1, file)
+      || length != key.length()) {
+    ::fclose(file);
+    return false;
+  }
+  std::string entry_key(length, '\0');
+  if (length && 1 != ::fread(&entry_key[0], length, 1, file)) {
+    ::fclose(file);
+    return false;
+  }
+  if (entry_key != key) {
+    ::fclose(file);
+    return false;
+  }
+  // Read the script data
+  if (1 != ::fread(&length, sizeof(length), 1, file) || !length) {
+    ::fclose(file);
+    return false;
+  }
+  data->resize(length);
+  if (1 != ::fread(&(*data)[0], length, 1, file)) {
+    data->clear();
+    ::fclose(file);
+    return false;
+  }
+  ::fclose(file);
+  return true;
+}
+
+void CodeCache::WriteEntry(const std::string& entry_name,
+    const std::string& key, v8::ScriptData* data) {
+  // Write to a temporary file and rename it so readers never see a
+  // partially written entry
+  std::string temp_name(entry_name);
+  temp_name.append(".XXXXXX");
+  int fd = ::mkstemp(&temp_name[0]);
+  if (-1 == fd) {
+    return;
+  }
+  FILE* file = ::fdopen(fd, "wb");
+  if (!file) {
+    ::close(fd);
+    ::unlink(temp_name.c_str());
+    return;
+  }
+  uint32_t key_length = key.length();
+  uint32_t data_length = data->Length();
+  bool status = 1 == ::fwrite(kMagic, sizeof(kMagic), 1, file)
+    && 1 == ::fwrite(&key_length, sizeof(key_length), 1, file)
+    && 1 == ::fwrite(key.data(), key_length, 1, file)
+    && 1 == ::fwrite(&data_length, sizeof(data_length), 1, file)
+    && 1 == ::fwrite(data->Data(), data_length, 1, file);
+  if (::fclose(file)) {
+    status = false;
+  }
+  if (!status || ::rename(temp_name.c_str(), entry_name.c_str())) {
+    ::unlink(temp_name.c_str());
+  }
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,152 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief An on-disk cache of V8 compilation data for script files
+ */
+
+#ifndef MOKA_CODE_CACHE_H
+#define MOKA_CODE_CACHE_H
+
+#include <ctime>
+#include <map>
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+class CodeCache;
+
+} // namespace internal
+
+} // namespace moka
+
+/// \brief A persistent compilation cache
+class moka::internal::CodeCache {
+public:
+  /**
+   * \brief Construct a code cache
+   *
+   * \param directory [in] The directory cache entries are stored in. If
+   *                       this is NULL or empty the cache is disabled and
+   *                       scripts are always compiled from source.
+   */
+  CodeCache(const char* directory);
+
+  /// \brief Destructor
+  ~CodeCache();
+
+  /**
+   * \brief Compile a script, consulting the cache
+   *
+   * Cache entries are keyed by the resolved path, modification time and
+   * size of the script file, whether the source has been wrapped in a
+   * module function, and the V8 version. If a valid entry
+   * is found it is handed to the compiler, otherwise the script is
+   * pre-compiled and a new entry is written.
+   *
+   * \param source [in] The script source
+   * \param file_name [in] The absolute path of the script file
+   * \param mtime [in] The modification time of the script file
+   * \param size [in] The size of the script file in bytes
+   * \param wrapped [in] Indicates if source is wrapped in a module function
+   *
+   * \return The compiled script. If compilation failed an empty handle is
+   *         returned and an exception is pending.
+   */
+  v8::Local<v8::Script> Compile(v8::Handle<v8::String> source,
+      const char* file_name, time_t mtime, off_t size, bool wrapped = false);
+
+  /**
+   * \brief Read a cache entry ahead of compilation
+   *
+   * The entry is held in memory until the script is compiled. This
+   * function does not use V8 and may be called from any thread.
+   *
+   * \param file_name [in] The absolute path of the script file
+   * \param mtime [in] The modification time of the script file
+   * \param size [in] The size of the script file in bytes
+   * \param wrapped [in] Indicates if source will be wrapped in a module
+   *                     function
+   */
+  void Prefetch(const char* file_name, time_t mtime, off_t size,
+      bool wrapped = false);
+
+  /**
+   * \brief Get the number of scripts compiled from a cache entry
+   *
+   * \return The cache hit count.
+   */
+  uint32_t GetHits() const {
+    return hits_;
+  }
+
+  /**
+   * \brief Get the number of scripts compiled without a cache entry
+   *
+   * \return The cache miss count.
+   */
+  uint32_t GetMisses() const {
+    return misses_;
+  }
+
+private: // non-copyable
+  CodeCache(CodeCache const& that);
+
+  void operator=(CodeCache const& that);
+
+private: // private methods
+  typedef std::map<std::string, std::string> PrefetchMap;
+
+  std::string GetKey(const char* file_name, time_t mtime, off_t size,
+      bool wrapped) const;
+
+  std::string GetEntryName(const std::string& key) const;
+
+  bool ReadEntry(const std::string& entry_name, const std::string& key,
+      std::string* data) const;
+
+  void WriteEntry(const std::string& entry_name, const std::string& key,
+      v8::ScriptData* data);
+
+private: // private data
+  std::string directory_;
+  std::string version_;
+  pthread_mutex_t mutex_;
+  PrefetchMap prefetched_;
+  uint32_t hits_;
+  uint32_t misses_;
+};
+
+#endif // MOKA_CODE_CACHE_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -44,40 +44,60 @@ v8::Handle<v8::FunctionTemplate> DataView::GetTemplate() {
   v8::Local<v8::FunctionTemplate> templ = v8::FunctionTemplate::New(New);
   templ->SetClassName(v8::String::NewSymbol("DataView"));
   templ->Inherit(ArrayBufferView::GetTemplate());
-  templ->InstanceTemplate()->SetInternalFieldCount(1);
+  templ->InstanceTemplate()->SetInternalFieldCount(kInternalFieldCount);
   // Methods
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getInt8"),
-      v8::FunctionTemplate::New(GetByte<int8_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method1<DataView, uint64_t,
+        &DataView::GetByte<int8_t> >::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getUint8"),
-      v8::FunctionTemplate::New(GetByte<uint8_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method1<DataView, uint64_t,
+        &DataView::GetByte<uint8_t> >::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getInt16"),
-      v8::FunctionTemplate::New(Get<int16_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, bool,
+        &DataView::Get<int16_t>, 1>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getUint16"),
-      v8::FunctionTemplate::New(Get<uint16_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, bool,
+        &DataView::Get<uint16_t>, 1>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getInt32"),
-      v8::FunctionTemplate::New(Get<int32_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, bool,
+        &DataView::Get<int32_t>, 1>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getUint32"),
-      v8::FunctionTemplate::New(Get<uint32_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, bool,
+        &DataView::Get<uint32_t>, 1>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getFloat32"),
-      v8::FunctionTemplate::New(Get<float>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, bool,
+        &DataView::Get<float>, 1>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("getDouble64"),
-      v8::FunctionTemplate::New(Get<double>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, bool,
+        &DataView::Get<double>, 1>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setInt8"),
-      v8::FunctionTemplate::New(SetByte<int8_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, int32_t,
+        &DataView::SetByte<int8_t> >::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setUint8"),
-      v8::FunctionTemplate::New(SetByte<int8_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method2<DataView, uint64_t, int32_t,
+        &DataView::SetByte<uint8_t> >::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setInt16"),
-      v8::FunctionTemplate::New(SetSigned<int16_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method3<DataView, uint64_t,
+        int32_t, bool, &DataView::Set<int16_t, int32_t>, 2>::Call)
+      ->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setUint16"),
-      v8::FunctionTemplate::New(SetUnsigned<uint16_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method3<DataView, uint64_t,
+        uint32_t, bool, &DataView::Set<uint16_t, uint32_t>, 2>::Call)
+      ->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setInt32"),
-      v8::FunctionTemplate::New(SetSigned<int32_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method3<DataView, uint64_t,
+        int32_t, bool, &DataView::Set<int32_t, int32_t>, 2>::Call)
+      ->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setUint32"),
-      v8::FunctionTemplate::New(SetUnsigned<uint32_t>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method3<DataView, uint64_t,
+        uint32_t, bool, &DataView::Set<uint32_t, uint32_t>, 2>::Call)
+      ->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setFloat32"),
-      v8::FunctionTemplate::New(SetRational<float>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method3<DataView, uint64_t,
+        double, bool, &DataView::Set<float, double>, 2>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("setDouble64"),
-      v8::FunctionTemplate::New(SetRational<double>)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method3<DataView, uint64_t,
+        double, bool, &DataView::Set<double, double>, 2>::Call)->GetFunction());
   templ_ = v8::Persistent<v8::FunctionTemplate>::New(templ);
   return templ_;
 }
@@ -87,22 +107,16 @@ v8::Handle<v8::Value> DataView::New(const v8::Arguments& arguments) {
     return Module::ConstructCall(GetTemplate(), arguments);
   }
   DataView* self = NULL;
-  uint32_t byte_offset = 0, byte_length = 0;
+  uint64_t byte_offset = 0, byte_length = 0;
   switch (arguments.Length()) {
   case 3:
-    if (arguments[2]->IsUint32()) {
-      byte_length = arguments[2]->ToUint32()->Value();
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument three must be an unsigned long")));
+    if (!binding::Unpack(arguments, 2, &byte_length)) {
+      return v8::Handle<v8::Value>();
     }
     // Fall through
   case 2:
-    if (arguments[1]->IsUint32()) {
-      byte_offset = arguments[1]->ToUint32()->Value();
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument two must be an unsigned long")));
+    if (!binding::Unpack(arguments, 1, &byte_offset)) {
+      return v8::Handle<v8::Value>();
     }
     // Fall through
   case 1:
@@ -111,6 +125,10 @@ v8::Handle<v8::Value> DataView::New(const v8::Arguments& arguments) {
       if (ArrayBuffer::GetTemplate()->HasInstance(object)) {
         moka::ArrayBuffer* buffer = static_cast<moka::ArrayBuffer*>(
             object->GetPointerFromInternalField(0));
+        if (byte_offset > buffer->GetByteLength()) {
+          return v8::ThrowException(v8::Exception::RangeError(
+                v8::String::New("Byte offset is out of range")));
+        }
         if (arguments.Length() < 3) {
           byte_length = buffer->GetByteLength() - byte_offset;
         } else {
@@ -122,8 +140,10 @@ v8::Handle<v8::Value> DataView::New(const v8::Arguments& arguments) {
         self = new DataView;
         if (self) {
           v8::Handle<v8::Value> value =
-            self->Construct(object, byte_offset, byte_length);
+            self->Construct(arguments.This(), object, byte_offset,
+                byte_length);
           if (value->IsUndefined()) {
+            delete self;
             return value;
           }
         }
@@ -143,7 +163,6 @@ v8::Handle<v8::Value> DataView::New(const v8::Arguments& arguments) {
   if (!self) {
     return v8::ThrowException(Module::ErrnoException::New(ENOMEM));
   }
-  v8::V8::AdjustAmountOfExternalAllocatedMemory(sizeof(DataView));
   v8::Persistent<v8::Object> data_view =
     v8::Persistent<v8::Object>::New(arguments.This());
   data_view->SetInternalField(0, v8::External::New(self));
@@ -153,8 +172,6 @@ v8::Handle<v8::Value> DataView::New(const v8::Arguments& arguments) {
 
 void DataView::Delete(v8::Persistent<v8::Value> object, void* parameters) {
   delete static_cast<DataView*>(parameters);
-  v8::V8::AdjustAmountOfExternalAllocatedMemory(
-      static_cast<int>(-sizeof(DataView)));
   object.Dispose();
   object.Clear();
 } 
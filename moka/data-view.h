@@ -29,6 +29,7 @@
 #define MOKA_DATA_VIEW_H
 
 #include "moka/array-buffer-view.h"
+#include "moka/binding.h"
 #include "moka/bytes.h"
 
 namespace moka {
@@ -46,209 +47,63 @@ private: // V8 interface
 
   static void Delete(v8::Persistent<v8::Value> object, void* parameters);
 
+private: // Native methods
   template<typename T>
-  static v8::Handle<v8::Value> GetByte(const v8::Arguments& arguments) {
-    switch (arguments.Length()) {
-    case 1:
-      if (arguments[0]->IsUint32()) {
-        uint32_t byte_offset = arguments[0]->ToUint32()->Value();
-        ArrayBufferView* self = static_cast<ArrayBufferView*>(
-            arguments.This()->GetPointerFromInternalField(0));
-        if (byte_offset >= self->GetByteLength()) {
-          return v8::ThrowException(v8::Exception::RangeError(
-                v8::String::New("Attempt to read beyond the end of the view")));
-        }
-        return v8::Number::New(
-            static_cast<T*>(self->GetBuffer())[byte_offset]);
-      } else {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be an unsigned long")));
-      }
-    default:
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("One argument required")));
+  v8::Handle<v8::Value> GetByte(uint64_t byte_offset) {
+    if (byte_offset >= GetByteLength()) {
+      return v8::ThrowException(v8::Exception::RangeError(
+            v8::String::New("Attempt to read beyond the end of the view")));
     }
+    return v8::Number::New(reinterpret_cast<T*>(GetData())[byte_offset]);
   }
 
   template<typename T>
-  static v8::Handle<v8::Value> Get(const v8::Arguments& arguments) {
-    bool little_endian = false;
-    switch (arguments.Length()) {
-    case 2:
-      little_endian = arguments[1]->ToBoolean()->Value();
-      // Fall through
-    case 1:
-      if (arguments[0]->IsUint32()) {
-        uint32_t byte_offset = arguments[0]->ToUint32()->Value();
-        ArrayBufferView* self = static_cast<ArrayBufferView*>(
-            arguments.This()->GetPointerFromInternalField(0));
-        if (byte_offset + sizeof(T) > self->GetByteLength()) {
-          return v8::ThrowException(v8::Exception::RangeError(
-                v8::String::New("Attempt to read beyond the end of the view")));
-        }
-        T value;
-        int8_t* buffer = static_cast<int8_t*>(self->GetBuffer()) + byte_offset;
-        if (little_endian) {
-          value = moka::bytes::Get<T, LITTLE_ENDIAN>()(buffer);
-        } else {
-          value = moka::bytes::Get<T, BIG_ENDIAN>()(buffer);
-        }
-        return v8::Number::New(value);
-      } else {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be an unsigned long")));
-      }
-    default:
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("One argument required")));
+  v8::Handle<v8::Value> Get(uint64_t byte_offset, bool little_endian) {
+    if (byte_offset + sizeof(T) > GetByteLength()) {
+      return v8::ThrowException(v8::Exception::RangeError(
+            v8::String::New("Attempt to read beyond the end of the view")));
     }
-  }
-
-  template<typename T>
-  static v8::Handle<v8::Value> SetByte(const v8::Arguments& arguments) {
-    if (2 == arguments.Length()) {
-      if (!arguments[1]->IsInt32()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument two must be a byte")));
-      }
-      if (!arguments[0]->IsUint32()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be an unsigned long")));
-      }
-      uint32_t byte_offset = arguments[0]->ToUint32()->Value();
-      ArrayBufferView* self = static_cast<ArrayBufferView*>(
-          arguments.This()->GetPointerFromInternalField(0));
-      if (byte_offset >= self->GetByteLength()) {
-        return v8::ThrowException(v8::Exception::RangeError(
-              v8::String::New("Attempt to write beyond the end of the view")));
-      }
-      static_cast<T*>(self->GetBuffer())[byte_offset] =
-        static_cast<T>(arguments[1]->ToInt32()->Value());
-      return v8::Null();
+    T value;
+    int8_t* buffer = GetData() + byte_offset;
+    if (little_endian) {
+      value = moka::bytes::Get<T, LITTLE_ENDIAN>()(buffer);
     } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Two arguments required")));
+      value = moka::bytes::Get<T, BIG_ENDIAN>()(buffer);
     }
+    return v8::Number::New(value);
   }
 
   template<typename T>
-  static v8::Handle<v8::Value> SetSigned(const v8::Arguments& arguments) {
-    int8_t* buffer;
-    uint32_t byte_offset;
-    bool little_endian = false;
-    ArrayBufferView* self = static_cast<ArrayBufferView*>(
-        arguments.This()->GetPointerFromInternalField(0));
-    switch (arguments.Length()) {
-    case 3:
-      little_endian = arguments[2]->ToBoolean()->Value();
-      // Fall Through
-    case 2:
-      if (!arguments[1]->IsInt32()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument two must be an integer")));
-      }
-      if (!arguments[0]->IsUint32()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be an unsigned long")));
-      }
-      byte_offset = arguments[0]->ToUint32()->Value();
-      if (byte_offset + sizeof(T) >= self->GetByteLength()) {
-        return v8::ThrowException(v8::Exception::RangeError(
-              v8::String::New("Attempt to write beyond the end of the view")));
-      }
-      buffer = static_cast<int8_t*>(self->GetBuffer()) + byte_offset;
-      if (little_endian) {
-        moka::bytes::Set<T, LITTLE_ENDIAN>()(
-            arguments[1]->ToInt32()->Value(), buffer);
-      } else {
-        moka::bytes::Set<T, BIG_ENDIAN>()(
-            arguments[1]->ToInt32()->Value(), buffer);
-      }
-      return v8::Null();
-    default:
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Two or three arguments required")));
+  v8::Handle<v8::Value> SetByte(uint64_t byte_offset, int32_t value) {
+    if (byte_offset >= GetByteLength()) {
+      return v8::ThrowException(v8::Exception::RangeError(
+            v8::String::New("Attempt to write beyond the end of the view")));
     }
+    reinterpret_cast<T*>(GetData())[byte_offset] = static_cast<T>(value);
+    return v8::Null();
   }
 
-  template<typename T>
-  static v8::Handle<v8::Value> SetUnsigned(const v8::Arguments& arguments) {
-    int8_t* buffer;
-    uint32_t byte_offset;
-    bool little_endian = false;
-    ArrayBufferView* self = static_cast<ArrayBufferView*>(
-        arguments.This()->GetPointerFromInternalField(0));
-    switch (arguments.Length()) {
-    case 3:
-      little_endian = arguments[2]->ToBoolean()->Value();
-      // Fall Through
-    case 2:
-      if (!arguments[1]->IsUint32()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument two must be an unsigned integer")));
-      }
-      if (!arguments[0]->IsUint32()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be an unsigned long")));
-      }
-      byte_offset = arguments[0]->ToUint32()->Value();
-      if (byte_offset + sizeof(T) >= self->GetByteLength()) {
-        return v8::ThrowException(v8::Exception::RangeError(
-              v8::String::New("Attempt to write beyond the end of the view")));
-      }
-      buffer = static_cast<int8_t*>(self->GetBuffer()) + byte_offset;
-      if (little_endian) {
-        moka::bytes::Set<T, LITTLE_ENDIAN>()(
-            arguments[1]->ToUint32()->Value(), buffer);
-      } else {
-        moka::bytes::Set<T, BIG_ENDIAN>()(
-            arguments[1]->ToUint32()->Value(), buffer);
-      }
-      return v8::Null();
-    default:
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Two or three arguments required")));
+  /**
+   * \brief Store a value
+   *
+   * \tparam T The stored type
+   * \tparam V The accepted argument type, i.e., int32_t for signed,
+   *           uint32_t for unsigned and double for floating point types
+   */
+  template<typename T, typename V>
+  v8::Handle<v8::Value> Set(uint64_t byte_offset, V value,
+      bool little_endian) {
+    if (byte_offset + sizeof(T) > GetByteLength()) {
+      return v8::ThrowException(v8::Exception::RangeError(
+            v8::String::New("Attempt to write beyond the end of the view")));
     }
-  }
-
-  template<typename T>
-  static v8::Handle<v8::Value> SetRational(const v8::Arguments& arguments) {
-    int8_t* buffer;
-    uint32_t byte_offset;
-    bool little_endian = false;
-    ArrayBufferView* self = static_cast<ArrayBufferView*>(
-        arguments.This()->GetPointerFromInternalField(0));
-    switch (arguments.Length()) {
-    case 3:
-      little_endian = arguments[2]->ToBoolean()->Value();
-      // Fall Through
-    case 2:
-      if (!arguments[1]->IsUint32()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument two must be an unsigned integer")));
-      }
-      if (!arguments[0]->IsNumber()) {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be a rational number")));
-      }
-      byte_offset = arguments[0]->ToUint32()->Value();
-      if (byte_offset + sizeof(T) >= self->GetByteLength()) {
-        return v8::ThrowException(v8::Exception::RangeError(
-              v8::String::New("Attempt to write beyond the end of the view")));
-      }
-      buffer = static_cast<int8_t*>(self->GetBuffer()) + byte_offset;
-      if (little_endian) {
-        moka::bytes::Set<T, LITTLE_ENDIAN>()(
-            arguments[1]->ToNumber()->Value(), buffer);
-      } else {
-        moka::bytes::Set<T, BIG_ENDIAN>()(
-            arguments[1]->ToNumber()->Value(), buffer);
-      }
-      return v8::Null();
-    default:
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Two or three arguments required")));
+    int8_t* buffer = GetData() + byte_offset;
+    if (little_endian) {
+      moka::bytes::Set<T, LITTLE_ENDIAN>()(value, buffer);
+    } else {
+      moka::bytes::Set<T, BIG_ENDIAN>()(value, buffer);
     }
+    return v8::Null();
   }
 
 private: // Private methods
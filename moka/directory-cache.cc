@@ -0,0 +1,166 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/directory-cache.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <dirent.h>
+#include "moka/directory-cache.h"
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+#include <unistd.h>
+
+namespace moka {
+
+namespace internal {
+
+DirectoryCache::DirectoryCache(time_t ttl)
+  : ttl_(ttl)
+  , inotify_fd_(-1) {
+#ifdef HAVE_SYS_INOTIFY_H
+  inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+DirectoryCache::~DirectoryCache() {
+  if (-1 != inotify_fd_) {
+    ::close(inotify_fd_);
+  }
+}
+
+void DirectoryCache::Refresh() {
+#ifdef HAVE_SYS_INOTIFY_H
+  if (-1 == inotify_fd_) {
+    return;
+  }
+  char buffer[4096]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  for (;;) {
+    ssize_t length = ::read(inotify_fd_, buffer, sizeof(buffer));
+    if (length <= 0) {
+      break;
+    }
+    char* position = buffer;
+    while (position < buffer + length) {
+      const struct inotify_event* event =
+        reinterpret_cast<const struct inotify_event*>(position);
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were lost
+        listings_.clear();
+      } else {
+        WatchMap::iterator iter = watches_.find(event->wd);
+        if (watches_.end() != iter) {
+          listings_.erase((*iter).second);
+          if (event->mask & IN_IGNORED) {
+            // The watch was removed, e.g., the directory was deleted
+            watches_.erase(iter);
+          }
+        }
+      }
+      position += sizeof(struct inotify_event) + event->len;
+    }
+  }
+#endif
+}
+
+bool DirectoryCache::MayContain(const char* directory, const char* id) {
+  std::string name(id);
+  std::string::size_type slash = name.find('/');
+  if (std::string::npos != slash) {
+    name.erase(slash);
+  }
+  if (name.empty() || "." == name || ".." == name) {
+    return true;
+  }
+  const Listing& listing = GetListing(directory);
+  if (!listing.complete) {
+    return true;
+  }
+  if (std::string::npos != slash) {
+    return listing.names.count(name);
+  }
+  return listing.names.count(name + ".js")
+    || listing.names.count(name + ".so") || listing.names.count(name);
+}
+
+time_t DirectoryCache::Now() {
+  struct timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec;
+}
+
+const DirectoryCache::Listing& DirectoryCache::GetListing(
+    const std::string& directory) {
+  ListingMap::iterator iter = listings_.find(directory);
+  if (listings_.end() != iter) {
+    Listing& listing = (*iter).second;
+    if (-1 != listing.watch || listing.expires > Now()) {
+      return listing;
+    }
+    listings_.erase(iter);
+  }
+  Listing& listing = listings_[directory];
+  listing.complete = false;
+  listing.watch = -1;
+  listing.expires = Now() + ttl_;
+#ifdef HAVE_SYS_INOTIFY_H
+  // Watch the directory before it is listed so no change is missed
+  if (-1 != inotify_fd_) {
+    listing.watch = ::inotify_add_watch(inotify_fd_, directory.c_str(),
+        IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+        | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+    if (-1 != listing.watch) {
+      watches_[listing.watch] = directory;
+    }
+  }
+#endif
+  DIR* dir = ::opendir(directory.c_str());
+  if (!dir) {
+    // A missing directory contains nothing, any other failure means the
+    // directory may still be searched
+    listing.complete = ENOENT == errno || ENOTDIR == errno;
+    return listing;
+  }
+  struct dirent* entry;
+  while ((entry = ::readdir(dir))) {
+    listing.names.insert(entry->d_name);
+  }
+  ::closedir(dir);
+  listing.complete = true;
+  return listing;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,124 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Cached listings of module search directories
+ */
+
+#ifndef MOKA_DIRECTORY_CACHE_H
+#define MOKA_DIRECTORY_CACHE_H
+
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+
+namespace moka {
+
+namespace internal {
+
+class DirectoryCache;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief A cache of directory listings
+ *
+ * The module factory uses this cache to skip search directories that do
+ * not contain a module without calling realpath() or open(). Listings are
+ * invalidated by inotify where it is available. Listings that can not be
+ * watched expire after a fixed time.
+ */
+class moka::internal::DirectoryCache {
+public:
+  /**
+   * \brief Construct a directory cache
+   *
+   * \param ttl [in] The number of seconds a listing that is not watched
+   *                 with inotify remains valid
+   */
+  DirectoryCache(time_t ttl);
+
+  /// \brief Destructor
+  ~DirectoryCache();
+
+  /**
+   * \brief Discard listings of directories that have changed
+   *
+   * This function should be called once before a search.
+   */
+  void Refresh();
+
+  /**
+   * \brief Check if a directory may contain a module
+   *
+   * For an ID without a slash the directory must contain 'id.js', 'id.so'
+   * or 'id' (e.g., a JSON module), otherwise it must contain the first
+   * term of id. IDs starting with '.' terms and directories that can not
+   * be listed are never ruled out.
+   *
+   * \param directory [in] A search directory
+   * \param id [in] A module ID
+   *
+   * \return This function returns false if directory does not contain
+   *         the module, true if it may.
+   */
+  bool MayContain(const char* directory, const char* id);
+
+private: // non-copyable
+  DirectoryCache(DirectoryCache const& that);
+
+  void operator=(DirectoryCache const& that);
+
+private: // private methods
+  struct Listing {
+    std::set<std::string> names;
+    bool complete;
+    int watch;
+    time_t expires;
+  };
+
+  typedef std::map<std::string, Listing> ListingMap;
+
+  typedef std::map<int, std::string> WatchMap;
+
+  static time_t Now();
+
+  const Listing& GetListing(const std::string& directory);
+
+private: // private data
+  time_t ttl_;
+  int inotify_fd_;
+  ListingMap listings_;
+  WatchMap watches_;
+};
+
+#endif // MOKA_DIRECTORY_CACHE_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,90 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/external-memory.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <climits>
+#include "moka/external-memory.h"
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+static const int64_t kThreshold = 256 * 1024;
+
+// Changes not yet reported to V8
+static __thread int64_t pending;
+
+// Changes not yet added to totals
+static __thread int64_t pending_totals[ExternalMemory::kTypeCount];
+
+static int64_t totals[ExternalMemory::kTypeCount];
+
+void ExternalMemory::Adjust(Type type, int64_t change) {
+  pending += change;
+  pending_totals[type] += change;
+  if (pending >= kThreshold || pending <= -kThreshold) {
+    Flush();
+  }
+}
+
+void ExternalMemory::Flush() {
+  for (int type = 0; type < kTypeCount; ++type) {
+    if (pending_totals[type]) {
+      __sync_fetch_and_add(&totals[type], pending_totals[type]);
+      pending_totals[type] = 0;
+    }
+  }
+  // V8 takes an int
+  while (pending) {
+    int change;
+    if (pending > INT_MAX) {
+      change = INT_MAX;
+    } else if (pending < -INT_MAX) {
+      change = -INT_MAX;
+    } else {
+      change = static_cast<int>(pending);
+    }
+    v8::V8::AdjustAmountOfExternalAllocatedMemory(change);
+    pending -= change;
+  }
+}
+
+int64_t ExternalMemory::GetTotal(Type type) {
+  return __sync_fetch_and_add(&totals[type], 0) + pending_totals[type];
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,104 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Batched accounting of external memory
+ */
+
+#ifndef MOKA_EXTERNAL_MEMORY_H
+#define MOKA_EXTERNAL_MEMORY_H
+
+#include <stdint.h>
+
+namespace moka {
+
+namespace internal {
+
+class ExternalMemory;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief Aggregates changes to the memory held by native objects
+ *
+ * Native objects report the memory they allocate and free with Adjust()
+ * instead of calling v8::V8::AdjustAmountOfExternalAllocatedMemory()
+ * directly. Changes are summed per thread and reported to V8 once the sum
+ * exceeds a threshold (256 KiB in either direction), so V8 sees at most
+ * one call per threshold worth of allocations and its GC heuristics run
+ * correspondingly less often. Totals are kept for each type of object.
+ */
+class moka::internal::ExternalMemory {
+public:
+  /// \brief Types of native objects
+  enum Type {
+    kArrayBuffer,
+    kView,
+    kTypeCount
+  };
+
+  /**
+   * \brief Account for memory allocated or freed by a native object
+   *
+   * This function must be called on a thread that has entered V8.
+   *
+   * \param type [in] The type of the object
+   * \param change [in] The number of bytes allocated (positive) or freed
+   *                    (negative)
+   */
+  static void Adjust(Type type, int64_t change);
+
+  /**
+   * \brief Report all pending changes of the current thread to V8
+   */
+  static void Flush();
+
+  /**
+   * \brief Get the memory currently held by a type of object
+   *
+   * \param type [in] A type of object
+   *
+   * \return The number of bytes held by all objects of type, including
+   *         changes of the current thread that have not been flushed.
+   *         Changes other threads have not flushed (less than the
+   *         threshold per thread) are not included.
+   */
+  static int64_t GetTotal(Type type);
+
+private: // non-copyable
+  ExternalMemory();
+
+  ExternalMemory(ExternalMemory const& that);
+
+  void operator=(ExternalMemory const& that);
+};
+
+#endif // MOKA_EXTERNAL_MEMORY_H
+
+// vim: tabstop=2:sw=2:expandtab
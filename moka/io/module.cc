@@ -29,6 +29,9 @@
 #include "config.h"
 #endif
 
+#ifdef MOKA_BUILTIN_IO
+#include "moka/builtin.h"
+#endif
 #include "moka/io/error.h"
 #include "moka/io/stream.h"
 #include "moka/module.h"
@@ -68,6 +71,10 @@ static v8::Handle<v8::Value> Initialize(int* argc, char*** argv) {
 
 } // namespace moka
 
+#ifdef MOKA_BUILTIN_IO
+MOKA_BUILTIN_MODULE("io", moka::io::Initialize)
+#else
 MOKA_MODULE(moka::io::Initialize)
+#endif
 
 // vim: tabstop=2:sw=2:expandtab
@@ -35,6 +35,7 @@
 #include "moka/io/buffer.h"
 #include "moka/io/error.h"
 #include "moka/io/stream.h"
+#include "moka/symbols.h"
 #include <string>
 
 namespace moka {
@@ -67,16 +68,16 @@ v8::Handle<v8::FunctionTemplate> Stream::GetTemplate() {
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("seek"),
       v8::FunctionTemplate::New(Seek)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("truncate"),
-      v8::FunctionTemplate::New(Seek)->GetFunction());
+      v8::FunctionTemplate::New(Truncate)->GetFunction());
   // Properties
-  templ->PrototypeTemplate()->SetAccessor(v8::String::NewSymbol("closed"),
-      ClosedGet);
-  templ->PrototypeTemplate()->SetAccessor(v8::String::NewSymbol("readable"),
-      ReadableGet);
-  templ->PrototypeTemplate()->SetAccessor(v8::String::NewSymbol("writable"),
-      WritableGet);
-  templ->PrototypeTemplate()->SetAccessor(v8::String::NewSymbol("seekable"),
-      SeekableGet);
+  templ->PrototypeTemplate()->SetAccessor(
+      internal::Symbols::Get(internal::Symbols::kClosed), ClosedGet);
+  templ->PrototypeTemplate()->SetAccessor(
+      internal::Symbols::Get(internal::Symbols::kReadable), ReadableGet);
+  templ->PrototypeTemplate()->SetAccessor(
+      internal::Symbols::Get(internal::Symbols::kWritable), WritableGet);
+  templ->PrototypeTemplate()->SetAccessor(
+      internal::Symbols::Get(internal::Symbols::kSeekable), SeekableGet);
   templ_ = v8::Persistent<v8::FunctionTemplate>::New(templ);
   return templ_;
 }
@@ -84,11 +85,13 @@ v8::Handle<v8::FunctionTemplate> Stream::GetTemplate() {
 v8::Handle<v8::Value> Stream::Write(v8::Handle<v8::Object> stream,
     v8::Handle<v8::Value> value) {
   v8::Handle<v8::Value> argv[1] = { value };
-  return Module::CallMethod(stream, "write", 1, argv);
+  return Module::CallMethod(stream,
+      internal::Symbols::Get(internal::Symbols::kWrite), 1, argv);
 }
 
 bool Stream::Closed(v8::Handle<v8::Object> stream) {
-  v8::Handle<v8::Value> value = stream->Get(v8::String::New("closed"));
+  v8::Handle<v8::Value> value = stream->Get(
+      internal::Symbols::Get(internal::Symbols::kClosed));
   v8::TryCatch try_catch;
   if (value.IsEmpty()) {
     return false;
@@ -97,7 +100,8 @@ bool Stream::Closed(v8::Handle<v8::Object> stream) {
 }
 
 bool Stream::Readable(v8::Handle<v8::Object> stream) {
-  v8::Handle<v8::Value> value = stream->Get(v8::String::New("readable"));
+  v8::Handle<v8::Value> value = stream->Get(
+      internal::Symbols::Get(internal::Symbols::kReadable));
   v8::TryCatch try_catch;
   if (value.IsEmpty()) {
     return false;
@@ -106,7 +110,8 @@ bool Stream::Readable(v8::Handle<v8::Object> stream) {
 }
 
 bool Stream::Writable(v8::Handle<v8::Object> stream) {
-  v8::Handle<v8::Value> value = stream->Get(v8::String::New("writable"));
+  v8::Handle<v8::Value> value = stream->Get(
+      internal::Symbols::Get(internal::Symbols::kWritable));
   v8::TryCatch try_catch;
   if (value.IsEmpty()) {
     return false;
@@ -115,7 +120,8 @@ bool Stream::Writable(v8::Handle<v8::Object> stream) {
 }
 
 bool Stream::Seekable(v8::Handle<v8::Object> stream) {
-  v8::Handle<v8::Value> value = stream->Get(v8::String::New("seekable"));
+  v8::Handle<v8::Value> value = stream->Get(
+      internal::Symbols::Get(internal::Symbols::kSeekable));
   v8::TryCatch try_catch;
   if (value.IsEmpty()) {
     return false;
@@ -124,7 +130,8 @@ bool Stream::Seekable(v8::Handle<v8::Object> stream) {
 }
 
 v8::Handle<v8::Value> Stream::Fileno(v8::Handle<v8::Object> stream) {
-  return Module::CallMethod(stream, "fileno", 0, NULL);
+  return Module::CallMethod(stream,
+      internal::Symbols::Get(internal::Symbols::kFileno), 0, NULL);
 }
 
 // Private implementation
@@ -164,6 +171,37 @@ v8::Handle<v8::Value> Stream::Flush() {
   return v8::True();
 }
 
+v8::Handle<v8::Value> Stream::CheckedSeek(off_t offset, int whence) {
+  switch (whence) {
+  case SEEK_SET:
+  case SEEK_CUR:
+  case SEEK_END:
+    return Seek(offset, whence);
+  default:
+    return v8::ThrowException(v8::Exception::TypeError(
+          v8::String::New("Argument two must be one of "
+            "SEEK_SET/SEEK_CUR/SEEK_END")));
+  }
+}
+
+Stream* Stream::Unwrap(v8::Handle<v8::Object> object, bool* native) {
+  *native = GetTemplate()->HasInstance(object)
+    && object->InternalFieldCount() > 0;
+  if (*native) {
+    return static_cast<Stream*>(object->GetPointerFromInternalField(0));
+  }
+  // A stream implemented in JavaScript, its prototype chain may contain a
+  // native stream
+  v8::Local<v8::Object> holder =
+    object->FindInstanceInPrototypeChain(GetTemplate());
+  if (!holder.IsEmpty() && holder->InternalFieldCount() > 0) {
+    return static_cast<Stream*>(holder->GetPointerFromInternalField(0));
+  }
+  // Otherwise every operation is unsupported
+  static Stream unsupported;
+  return &unsupported;
+}
+
 // Private V8 interface
 v8::Handle<v8::Value> Stream::New(const v8::Arguments& arguments) {
   std::string message("Cannot instantiate the type ");
@@ -175,52 +213,38 @@ v8::Handle<v8::Value> Stream::New(const v8::Arguments& arguments) {
 
 v8::Handle<v8::Value> Stream::Close(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::True();
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  switch (arguments.Length()) {
-  case 0:
-      return self->Close();
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("Zero arguments allowed")));
-  }
+  return binding::Method0<Stream, &Stream::Close>::Invoke(self, arguments);
 }
 
 v8::Handle<v8::Value> Stream::Read(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("read: File is closed"));
   }
-  if (!Readable(object)) {
+  if (!(native ? self->Readable() : Readable(object))) {
     return v8::ThrowException(Error::New("read: File is not readable"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  switch (arguments.Length()) {
-  case 1:
-    if (arguments[0]->IsUint32()) {
-      return self->Read(arguments[0]->ToUint32()->Value());
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument one must be an unsigned integer")));
-    }
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("One argument allowed")));
-  }
-
+  return binding::Method1<Stream, size_t, &Stream::Read>::Invoke(self,
+      arguments);
 }
 
 v8::Handle<v8::Value> Stream::Write(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("write: File is closed"));
   }
-  if (!Writable(object)) {
+  if (!(native ? self->Writable() : Writable(object))) {
     return v8::ThrowException(Error::New("write: File is not writable"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
   switch (arguments.Length()) {
     case 1:
       {
@@ -239,134 +263,73 @@ v8::Handle<v8::Value> Stream::Write(const v8::Arguments& arguments) {
 
 v8::Handle<v8::Value> Stream::Flush(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("flush: File is closed"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  switch (arguments.Length()) {
-  case 0:
-    return self->Flush();
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("Zero arguments allowed")));
-  }
+  return binding::Method0<Stream, &Stream::Flush>::Invoke(self, arguments);
 }
 
 v8::Handle<v8::Value> Stream::Fileno(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("fileno: File is closed"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  switch (arguments.Length()) {
-  case 0:
-    return self->Fileno();
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("Zero arguments allowed")));
-  }
+  return binding::Method0<Stream, &Stream::Fileno>::Invoke(self, arguments);
 }
 
 v8::Handle<v8::Value> Stream::Isatty(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("isatty: File is closed"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  switch (arguments.Length()) {
-  case 0:
-    return self->Isatty();
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("Zero arguments allowed")));
-  }
+  return binding::Method0<Stream, &Stream::Isatty>::Invoke(self, arguments);
 }
 
 v8::Handle<v8::Value> Stream::Tell(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("tell: File is closed"));
   }
-  if (!Seekable(object)) {
+  if (!(native ? self->Seekable() : Seekable(object))) {
     return v8::ThrowException(Error::New("tell: File is not seekable"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  switch (arguments.Length()) {
-  case 0:
-    return self->Tell();
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("Zero arguments allowed")));
-  }
+  return binding::Method0<Stream, &Stream::Tell>::Invoke(self, arguments);
 }
 
 v8::Handle<v8::Value> Stream::Seek(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("seek: File is closed"));
   }
-  if (!Seekable(object)) {
+  if (!(native ? self->Seekable() : Seekable(object))) {
     return v8::ThrowException(Error::New("seek: File is not seekable"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  int whence = SEEK_SET;
-  switch (arguments.Length()) {
-  case 2:
-    if (arguments[1]->IsInt32()) {
-      whence = arguments[1]->ToInt32()->Value();
-      switch (whence) {
-      case SEEK_SET:
-      case SEEK_CUR:
-      case SEEK_END:
-        // Do nothing
-        break;
-      default:
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument one must be one of "
-                "SEEK_SET/SEEK_CUR/SEEK_END")));
-      }
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument one must be an integer")));
-    }
-    // Fall through
-  case 1:
-    if (arguments[0]->IsInt32()) {
-      return self->Seek(arguments[0]->ToInt32()->Value(), whence);
-    }
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("Argument one must be an integer")));
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("One or two argument(s) allowed")));
-  }
+  return binding::Method2<Stream, off_t, int,
+      &Stream::CheckedSeek, 1>::Invoke(self, arguments);
 }
 
 v8::Handle<v8::Value> Stream::Truncate(const v8::Arguments& arguments) {
   v8::Handle<v8::Object> object = arguments.This();
-  if (Closed(object)) {
+  bool native;
+  Stream* self = Unwrap(object, &native);
+  if (native ? self->Closed() : Closed(object)) {
     return v8::ThrowException(Error::New("truncate: File is closed"));
   }
-  if (!Seekable(object)) {
+  if (!(native ? self->Seekable() : Seekable(object))) {
     return v8::ThrowException(Error::New("truncate: File is not seekable"));
   }
-  Stream* self = static_cast<Stream*>(object->GetPointerFromInternalField(0));
-  off_t length = 0;
-  switch (arguments.Length()) {
-  case 1:
-    if (arguments[1]->IsInt32()) {
-      length = arguments[1]->ToInt32()->Value();
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument one must be an integer")));
-    }
-    // Fall through
-  case 0:
-    return self->Truncate(length);
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("Zero or one argument(s) allowed")));
-  }
+  return binding::Method1<Stream, off_t, &Stream::Truncate, 0>::Invoke(self,
+      arguments);
 }
 
 v8::Handle<v8::Value> Stream::ClosedGet(v8::Local<v8::String> property,
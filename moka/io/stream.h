@@ -28,6 +28,7 @@
 #ifndef MOKA_IO_STREAM_H
 #define MOKA_IO_STREAM_H
 
+#include "moka/binding.h"
 #include "moka/module.h"
 
 namespace moka {
@@ -93,6 +94,9 @@ private: // Class implementation
     return false;
   }
 
+  /// \brief Seek after checking that whence is a SEEK_* constant
+  v8::Handle<v8::Value> CheckedSeek(off_t offset, int whence);
+
 private: // V8 interface
   static v8::Handle<v8::Value> New(const v8::Arguments& arguments);
 
@@ -135,6 +139,21 @@ private: // Private methods
   Stream(Stream const& that);
 
   void operator=(Stream const& that);
+
+  /**
+   * \brief Get the native stream of a method call
+   *
+   * The state of a native stream is read by calling Closed(), Readable(),
+   * etc. directly. The state of a stream implemented in JavaScript is
+   * read from its 'closed', 'readable', etc. properties, which it may
+   * override.
+   *
+   * \param object [in] The receiver of a method call
+   * \param native [out] Set to true if object is a native stream
+   *
+   * \return The native stream that implements the method.
+   */
+  static Stream* Unwrap(v8::Handle<v8::Object> object, bool* native);
 };
 
 #endif // MOKA_IO_STREAM_H
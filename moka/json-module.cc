@@ -0,0 +1,183 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/json-module.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include "moka/json-module.h"
+#include "moka/script-source.h"
+#include "moka/tracer.h"
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace moka {
+
+namespace internal {
+
+/// \brief A parsed JSON file
+struct JsonEntry {
+  time_t mtime;
+  off_t size;
+  v8::Persistent<v8::Value> value;
+};
+
+typedef std::map<std::string, JsonEntry> JsonCache;
+
+/**
+ * \brief Get the parse cache
+ *
+ * \return The parse cache shared by all module loaders.
+ */
+static JsonCache& GetCache() {
+  static JsonCache cache;
+  return cache;
+}
+
+/**
+ * \brief Freeze a value and everything reachable from it
+ *
+ * \param freeze [in] The 'Object.freeze' function
+ * \param value [in] A value returned by 'JSON.parse'
+ *
+ * \return This function returns true if the value was frozen, false if
+ *         an exception was thrown.
+ */
+static bool DeepFreeze(v8::Handle<v8::Function> freeze,
+    v8::Handle<v8::Value> value) {
+  if (!value->IsObject()) {
+    return true;
+  }
+  v8::HandleScope handle_scope;
+  v8::Local<v8::Object> object = value->ToObject();
+  v8::Local<v8::Array> names = object->GetPropertyNames();
+  for (uint32_t index = 0; index < names->Length(); ++index) {
+    if (!DeepFreeze(freeze, object->Get(names->Get(index)))) {
+      return false;
+    }
+  }
+  v8::Handle<v8::Value> argv[1] = { object };
+  return !freeze->Call(object, 1, argv).IsEmpty();
+}
+
+/**
+ * \brief Throw an exception for a file that can not be read
+ *
+ * \param id [in] The module ID
+ * \param error [in] An errno value
+ *
+ * \return An empty handle.
+ */
+static v8::Handle<v8::Value> ThrowReadError(const char* id, int error) {
+  char message[BUFSIZ];
+  ::strerror_r(error, message, BUFSIZ);
+  std::string exception("Loading module ");
+  exception.append(id);
+  exception.append(": ");
+  exception.append(message);
+  v8::ThrowException(v8::String::New(exception.c_str()));
+  return v8::Handle<v8::Value>();
+}
+
+JsonModule::JsonModule(const char* id, const char* file_name, bool secure,
+    v8::Handle<v8::Object> require, v8::Handle<v8::Function> parse,
+    v8::Handle<v8::Function> freeze, Tracer* tracer)
+  : Module(id, file_name, secure, require, v8::Handle<v8::Context>(), true)
+  , parse_(parse)
+  , freeze_(freeze)
+  , tracer_(tracer) {}
+
+v8::Handle<v8::Value> JsonModule::Load() {
+  v8::HandleScope handle_scope;
+  // Reuse the parsed value unless the file changed
+  struct stat buf;
+  if (::stat(GetFileName(), &buf)) {
+    return ThrowReadError(GetId(), errno);
+  }
+  JsonCache& cache = GetCache();
+  JsonCache::iterator iter = cache.find(GetFileName());
+  if (cache.end() != iter && iter->second.mtime == buf.st_mtime
+      && iter->second.size == buf.st_size) {
+    return handle_scope.Close(iter->second.value);
+  }
+  FILE* file = ::fopen(GetFileName(), "rb");
+  if (!file) {
+    return ThrowReadError(GetId(), errno);
+  }
+  if (::fstat(fileno(file), &buf)) {
+    int error = errno;
+    ::fclose(file);
+    return ThrowReadError(GetId(), error);
+  }
+  // Read the file
+  Tracer::Scope read_trace(tracer_, "phase", "read", GetFileName());
+  ScriptSource* source = new FileSource(file, buf.st_size, buf.st_mtime);
+  if (!source) {
+    ::fclose(file);
+    return ThrowReadError(GetId(), ENOMEM);
+  }
+  v8::Local<v8::String> text = source->NewString();
+  int error = errno;
+  delete source;
+  if (text.IsEmpty()) {
+    return ThrowReadError(GetId(), error);
+  }
+  read_trace.End();
+  // Parse and freeze the value
+  Tracer::Scope parse_trace(tracer_, "phase", "parse", GetFileName());
+  v8::TryCatch try_catch;
+  v8::Handle<v8::Value> argv[1] = { text };
+  v8::Handle<v8::Value> value =
+    parse_->Call(v8::Context::GetCurrent()->Global(), 1, argv);
+  if (value.IsEmpty()) {
+    return try_catch.ReThrow();
+  }
+  // The value is shared by every requirer, never cache it unfrozen
+  if (!DeepFreeze(freeze_, value)) {
+    return try_catch.ReThrow();
+  }
+  // Cache the value
+  JsonEntry& entry = cache[GetFileName()];
+  entry.value.Dispose();
+  entry.value = v8::Persistent<v8::Value>::New(value);
+  entry.mtime = buf.st_mtime;
+  entry.size = buf.st_size;
+  return handle_scope.Close(value);
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
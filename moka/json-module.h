@@ -0,0 +1,106 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief A JSON data module
+ */
+
+#ifndef MOKA_JSON_MODULE_H
+#define MOKA_JSON_MODULE_H
+
+#include "moka/module.h"
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+class JsonModule;
+class Tracer;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief A JSON module
+ *
+ * Requiring a module ID ending in '.json' returns the parsed content of
+ * the file instead of an 'exports' object. Parsed values are deeply
+ * frozen and cached for the life of the process, keyed by the absolute
+ * path, modification time and size of the file, so every module context
+ * requiring the file shares the same value. A file that changes is parsed
+ * again when it is next required.
+ *
+ * JSON modules have no context of their own. The file is parsed and
+ * frozen with the 'JSON.parse' and 'Object.freeze' functions the module
+ * loader recorded before any script ran, so a script that replaces them
+ * can not change the value other modules receive. A value that can not be
+ * frozen fails the require and is not cached.
+ */
+class moka::internal::JsonModule: public moka::Module {
+public:
+  /**
+   * \brief Construct a module from a JSON file
+   *
+   * \param id [in] The ID of the new module
+   * \param file_name [in] The absolute path of the JSON file
+   * \param secure [in] Indicates if this should be a secure module
+   * \param require [in] The object implementing the 'require' function
+   * \param parse [in] The 'JSON.parse' function to parse the file with
+   * \param freeze [in] The 'Object.freeze' function to freeze the value
+   *                    with
+   * \param tracer [in] The tracer loading phases are recorded in, may be
+   *                    NULL
+   */
+  JsonModule(const char* id, const char* file_name, bool secure,
+      v8::Handle<v8::Object> require, v8::Handle<v8::Function> parse,
+      v8::Handle<v8::Function> freeze, Tracer* tracer);
+
+  /// \brief Destructor
+  virtual ~JsonModule() {}
+
+  /**
+   * \brief Load a JSON module
+   *
+   * This function returns the cached value of the file if it has not
+   * changed, otherwise the file is read and parsed.
+   *
+   * \return The parsed value. If the file could not be read or parsed an
+   *         exception is thrown and an empty handle is returned.
+   */
+  virtual v8::Handle<v8::Value> Load();
+
+private:
+  v8::Persistent<v8::Function> parse_;
+  v8::Persistent<v8::Function> freeze_;
+  Tracer* tracer_;
+};
+
+#endif // MOKA_JSON_MODULE_H
+
+// vim: tabstop=2:sw=2:expandtab
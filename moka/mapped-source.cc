@@ -0,0 +1,82 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/mapped-source.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "moka/mapped-source.h"
+#include <sys/mman.h>
+
+namespace moka {
+
+namespace internal {
+
+MappedSource* MappedSource::New(int fd, size_t size) {
+  void* address = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (MAP_FAILED == address) {
+    return NULL;
+  }
+  MappedSource* source = new MappedSource(address, size);
+  if (!source) {
+    ::munmap(address, size);
+    return NULL;
+  }
+  return source;
+}
+
+v8::Local<v8::String> MappedSource::NewString(MappedSource* source) {
+  if (source->IsAscii()) {
+    return v8::String::NewExternal(source);
+  }
+  v8::Local<v8::String> string =
+    v8::String::New(source->data(), source->length());
+  delete source;
+  return string;
+}
+
+MappedSource::~MappedSource() {
+  ::munmap(address_, length_);
+}
+
+bool MappedSource::IsAscii() const {
+  const unsigned char* data = static_cast<const unsigned char*>(address_);
+  for (size_t index = 0; index < length_; ++index) {
+    if (data[index] & 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,116 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Script source code backed by a read-only file mapping
+ */
+
+#ifndef MOKA_MAPPED_SOURCE_H
+#define MOKA_MAPPED_SOURCE_H
+
+#include <cstddef>
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+class MappedSource;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief A memory mapped script source
+ *
+ * V8 reads the source of an external string long after it was compiled,
+ * e.g., to compile functions lazily or for Function.prototype.toString.
+ * Truncating a mapped file in place makes those reads fault with SIGBUS.
+ * Scripts must therefore be replaced by renaming a new file over the old
+ * one (the mapping keeps the old file alive), never rewritten in place,
+ * while a process that loaded them is running.
+ */
+class moka::internal::MappedSource:
+  public v8::String::ExternalAsciiStringResource {
+public:
+  /**
+   * \brief Map a file into memory
+   *
+   * \param fd [in] An open file descriptor (the caller retains ownership)
+   * \param size [in] The number of bytes to map, must be non-zero
+   *
+   * \return A new mapped source or NULL if the file could not be mapped,
+   *         in which case errno is set.
+   */
+  static MappedSource* New(int fd, size_t size);
+
+  /**
+   * \brief Create a V8 string from a mapped source
+   *
+   * If the source is pure ASCII it is handed to V8 as an external string
+   * and the pages are never copied onto the heap; V8 takes ownership of
+   * source. Otherwise the source is decoded as UTF-8 and source is
+   * deleted.
+   *
+   * \param source [in] A mapped source (ownership is transferred)
+   *
+   * \return A string containing the source.
+   */
+  static v8::Local<v8::String> NewString(MappedSource* source);
+
+  /// \brief Unmaps the file
+  virtual ~MappedSource();
+
+  virtual const char* data() const {
+    return static_cast<const char*>(address_);
+  }
+
+  virtual size_t length() const {
+    return length_;
+  }
+
+private: // non-copyable
+  MappedSource(MappedSource const& that);
+
+  void operator=(MappedSource const& that);
+
+private: // private methods
+  MappedSource(void* address, size_t length)
+    : address_(address)
+    , length_(length) {}
+
+  bool IsAscii() const;
+
+private: // private data
+  void* address_;
+  size_t length_;
+};
+
+#endif // MOKA_MAPPED_SOURCE_H
+
+// vim: tabstop=2:sw=2:expandtab
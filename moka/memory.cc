@@ -0,0 +1,59 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/memory.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "moka/buffer-pool.h"
+#include "moka/external-memory.h"
+#include "moka/memory.h"
+
+namespace moka {
+
+void Memory::GetStatistics(Statistics* statistics) {
+  statistics->array_buffer_bytes =
+    internal::ExternalMemory::GetTotal(internal::ExternalMemory::kArrayBuffer);
+  statistics->view_bytes =
+    internal::ExternalMemory::GetTotal(internal::ExternalMemory::kView);
+  internal::BufferPool::GetMappedStats(&statistics->mapped_bytes,
+      &statistics->resident_bytes);
+}
+
+bool Memory::SetBufferPool(bool enabled) {
+  return internal::BufferPool::SetEnabled(enabled);
+}
+
+void Memory::SetHugePages(bool enabled) {
+  internal::BufferPool::SetHugePages(enabled);
+}
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,118 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \file
+ * \brief Interface to the memory held by native objects
+ */
+
+#ifndef MOKA_MEMORY_H
+#define MOKA_MEMORY_H
+
+#include <cstddef>
+#include <moka/macros.h>
+#include <stdint.h>
+
+namespace moka {
+
+class Memory;
+
+} // namespace moka
+
+/**
+ * \brief Process-wide statistics and settings of the memory held by
+ *        native objects
+ *
+ * The memory held by ArrayBuffers and views is reported to V8 as external
+ * memory in batches of 256 KiB per thread.
+ */
+class MOKA_EXPORT moka::Memory {
+public:
+  /// \brief A snapshot of the memory held by native objects
+  struct Statistics {
+    /// \brief Bytes held by ArrayBuffers, including their contents
+    int64_t array_buffer_bytes;
+    /// \brief Bytes held by views on ArrayBuffers
+    int64_t view_bytes;
+    /// \brief Bytes mapped for ArrayBuffer contents of 1 MiB and more
+    size_t mapped_bytes;
+    /// \brief Bytes of the mapped contents that are resident
+    size_t resident_bytes;
+  };
+
+  /**
+   * \brief Get the memory held by native objects
+   *
+   * Changes made by the calling thread are included in full. Each other
+   * thread may hold back up to 256 KiB of changes it has not yet
+   * reported, so totals that include work done on other threads are
+   * approximate.
+   *
+   * \param statistics [out] The current statistics
+   */
+  static void GetStatistics(Statistics* statistics);
+
+  /**
+   * \brief Recycle ArrayBuffer contents through a pool
+   *
+   * Contents of 16 B to 64 KiB are rounded up to a power of two and kept
+   * on per-thread free lists when they are freed. The pool is disabled by
+   * default. The setting is latched when the first ArrayBuffer is
+   * allocated, so this function should be called before any script runs.
+   *
+   * \param enabled [in] True to enable the pool
+   *
+   * \return This function returns false if an ArrayBuffer has already been
+   *         allocated with the other setting, which then stays in effect,
+   *         true otherwise.
+   */
+  static bool SetBufferPool(bool enabled);
+
+  /**
+   * \brief Back large ArrayBuffer contents with transparent huge pages
+   *
+   * Contents of 2 MiB and more are aligned to 2 MiB and advised with
+   * madvise(MADV_HUGEPAGE). This reduces TLB misses on large, densely
+   * used buffers at the cost of making every touched huge page resident
+   * in full. Disabled by default, the setting applies to ArrayBuffers
+   * allocated after the call.
+   *
+   * \param enabled [in] True to use huge pages
+   */
+  static void SetHugePages(bool enabled);
+
+private: // non-copyable
+  Memory();
+
+  Memory(Memory const& that);
+
+  void operator=(Memory const& that);
+};
+
+#endif // MOKA_MEMORY_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -29,9 +29,16 @@
 
 #include <cstdlib>
 #include <dlfcn.h>
+#include "moka/builtin.h"
+#include "moka/directory-cache.h"
+#include "moka/json-module.h"
 #include "moka/module-factory.h"
+#include "moka/prefetcher.h"
+#include "moka/preloader.h"
 #include "moka/script-module.h"
+#include "moka/script-source.h"
 #include "moka/so-module.h"
+#include "moka/tracer.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -41,11 +48,25 @@ namespace moka {
 namespace internal {
 
 ModuleFactory::ModuleFactory(bool secure, v8::Handle<v8::Object> require,
-    ModulePointer module, int* argc, char*** argv)
+    ModulePointer module, int* argc, char*** argv, CodeCache* code_cache,
+    v8::Persistent<v8::Context> context,
+    v8::Persistent<v8::Function> json_parse,
+    v8::Persistent<v8::Function> json_freeze, BundlePointer bundle,
+    Prefetcher* prefetcher, Preloader* preloader,
+    DirectoryCache* directory_cache, Tracer* tracer)
   : secure_(secure)
   , require_(require)
   , argc_(argc)
-  , argv_(argv) {
+  , argv_(argv)
+  , code_cache_(code_cache)
+  , context_(context)
+  , json_parse_(json_parse)
+  , json_freeze_(json_freeze)
+  , bundle_(bundle)
+  , prefetcher_(prefetcher)
+  , preloader_(preloader)
+  , directory_cache_(directory_cache)
+  , tracer_(tracer) {
   // Insert the main module into the module store
   modules_.insert(ModulePair(module->GetFileName(), module));
 }
@@ -66,27 +87,203 @@ ModulePointer ModuleFactory::NewScriptModule(const char* id, const char* path) {
   if (modules_.end() != iter) {
     return (*iter).second;
   }
-  // Open the script
-  FILE* file = ::fopen(resolved_path_, "rb");
-  if (!file) {
+  // Claim the script if it has been prefetched, otherwise open it
+  ScriptSource* source = NULL;
+  if (prefetcher_) {
+    source = prefetcher_->Take(resolved_path_);
+  }
+  if (!source) {
+    FILE* file = ::fopen(resolved_path_, "rb");
+    if (!file) {
+      return module;
+    }
+    // Get file statistics
+    struct stat buf;
+    if (::fstat(fileno(file), &buf)) {
+      ::fclose(file);
+      return module;
+    }
+    // Ensure this file is a regular file, i.e., not a directory
+    if (!S_ISREG(buf.st_mode)) {
+      ::fclose(file);
+      return module;
+    }
+    source = new FileSource(file, buf.st_size, buf.st_mtime);
+    if (!source) {
+      ::fclose(file);
+      return module;
+    }
+  }
+  // Create a new script module
+  if (context_.IsEmpty()) {
+    module.reset(new ScriptModule(id, resolved_path_, secure_, require_,
+          source, code_cache_, tracer_));
+  } else {
+    module.reset(new ScriptModule(id, resolved_path_, secure_, require_,
+          context_, source, code_cache_, tracer_, true));
+  }
+  if (!module.get()) {
+    delete source;
     return module;
   }
-  // Get file statistics
-  struct stat buf;
-  if (::fstat(fileno(file), &buf)) {
-    ::fclose(file);
+  // Read the dependencies of this module in the background
+  if (prefetcher_) {
+    prefetcher_->Scan(resolved_path_);
+  }
+  // Insert the module into the module store
+  modules_.insert(ModulePair(module->GetFileName(), module));
+  return module;
+}
+
+ModulePointer ModuleFactory::NewJsonModule(const char* id, const char* path) {
+  ModulePointer module;
+  // Construct a full file name, the ID includes the suffix
+  std::string file_name(path);
+  file_name.append("/");
+  file_name.append(id);
+  // Resolve links/relative references
+  if (!realpath(file_name.c_str(), resolved_path_)) {
     return module;
   }
+  // Check for a previously loaded module
+  ModuleMap::iterator iter = modules_.find(resolved_path_);
+  if (modules_.end() != iter) {
+    return (*iter).second;
+  }
   // Ensure this file is a regular file, i.e., not a directory
-  if (!S_ISREG(buf.st_mode)) {
-    ::fclose(file);
+  struct stat buf;
+  if (::stat(resolved_path_, &buf) || !S_ISREG(buf.st_mode)) {
+    return module;
+  }
+  // Create a new JSON module
+  module.reset(new JsonModule(id, resolved_path_, secure_, require_,
+        json_parse_, json_freeze_, tracer_));
+  if (!module.get()) {
+    return module;
+  }
+  // Insert the module into the module store
+  modules_.insert(ModulePair(module->GetFileName(), module));
+  return module;
+}
+
+ModulePointer ModuleFactory::NewBuiltinModule(const char* id) {
+  ModulePointer module;
+  const struct module* init = Builtin::Find(id);
+  if (!init) {
+    return module;
+  }
+  std::string file_name("builtin:");
+  file_name.append(id);
+  // Check for a previously loaded module
+  ModuleMap::iterator iter = modules_.find(file_name);
+  if (modules_.end() != iter) {
+    return (*iter).second;
+  }
+  // Create a new built-in module
+  module.reset(new SoModule(id, file_name.c_str(), secure_, require_, init,
+        argc_, argv_, tracer_));
+  if (!module.get()) {
+    return module;
+  }
+  // Insert the module into the module store, it is never unloaded
+  modules_.insert(ModulePair(module->GetFileName(), module));
+  resident_.insert(module->GetFileName());
+  return module;
+}
+
+/**
+ * \brief Normalize a slash separated module ID
+ *
+ * Empty and '.' terms are removed and '..' terms remove the preceding
+ * term.
+ *
+ * \param id [in] A module ID
+ * \param normalized [out] The normalized ID
+ *
+ * \return This function returns false if id refers above its root, true
+ *         otherwise.
+ */
+static bool NormalizeId(const std::string& id, std::string& normalized) {
+  normalized.clear();
+  std::string::size_type begin = 0;
+  while (begin <= id.length()) {
+    std::string::size_type end = id.find('/', begin);
+    if (std::string::npos == end) {
+      end = id.length();
+    }
+    std::string term(id, begin, end - begin);
+    if (".." == term) {
+      if (normalized.empty()) {
+        return false;
+      }
+      std::string::size_type slash = normalized.rfind('/');
+      normalized.erase(std::string::npos == slash ? 0 : slash);
+    } else if (!term.empty() && "." != term) {
+      if (!normalized.empty()) {
+        normalized.append("/");
+      }
+      normalized.append(term);
+    }
+    begin = end + 1;
+  }
+  return true;
+}
+
+ModulePointer ModuleFactory::NewBundleModule(const char* id,
+    const char* path) {
+  ModulePointer module;
+  if (!bundle_.get()) {
+    return module;
+  }
+  // Relative IDs are resolved in the bundle only for modules loaded from it
+  std::string bundle_id;
+  if (path) {
+    std::string root(bundle_->GetFileName());
+    std::string directory(path);
+    if (directory == root) {
+      bundle_id.assign(id);
+    } else if (0 == directory.compare(0, root.length() + 1, root + "/")) {
+      bundle_id.assign(directory, root.length() + 1, std::string::npos);
+      bundle_id.append("/");
+      bundle_id.append(id);
+    } else {
+      return module;
+    }
+  } else {
+    bundle_id.assign(id);
+  }
+  std::string normalized;
+  if (!NormalizeId(bundle_id, normalized)) {
+    return module;
+  }
+  const BundleEntry* entry = bundle_->Find(normalized);
+  if (!entry) {
+    return module;
+  }
+  // Name the module as if the bundle were a directory
+  std::string file_name(bundle_->GetFileName());
+  file_name.append("/");
+  file_name.append(normalized);
+  file_name.append(".js");
+  // Check for a previously loaded module
+  ModuleMap::iterator iter = modules_.find(file_name);
+  if (modules_.end() != iter) {
+    return (*iter).second;
+  }
+  ScriptSource* source = new BundleSource(bundle_, entry);
+  if (!source) {
     return module;
   }
   // Create a new script module
-  module.reset(new ScriptModule(id, resolved_path_, secure_, require_, file,
-        buf.st_size));
+  if (context_.IsEmpty()) {
+    module.reset(new ScriptModule(id, file_name.c_str(), secure_, require_,
+          source, code_cache_, tracer_));
+  } else {
+    module.reset(new ScriptModule(id, file_name.c_str(), secure_, require_,
+          context_, source, code_cache_, tracer_, true));
+  }
   if (!module.get()) {
-    ::fclose(file);
+    delete source;
     return module;
   }
   // Insert the module into the module store
@@ -110,26 +307,95 @@ ModulePointer ModuleFactory::NewSoModule(const char* id, const char* path) {
   if (modules_.end() != iter) {
     return (*iter).second;
   }
-  // Invoke the dynamic linker to open the shared object
-  void* handle = ::dlopen(file_name.c_str(), RTLD_LAZY);
+  // Adopt the shared object if it has been preloaded, otherwise invoke the
+  // dynamic linker to open it
+  Tracer::Scope trace(tracer_, "phase", "dlopen", resolved_path_);
+  void* handle = NULL;
+  if (preloader_) {
+    handle = preloader_->Take(resolved_path_);
+  }
+  if (!handle) {
+    handle = ::dlopen(file_name.c_str(), RTLD_LAZY);
+  }
+  trace.End();
   if (!handle) {
     return module;
   }
   // Create a new shared object module
   module.reset(new SoModule(id, resolved_path_, secure_, require_, handle,
-        argc_, argv_));
+        argc_, argv_, tracer_));
   if (!module.get()) {
     ::dlclose(handle);
     return module;
   }
-  // Insert the module into the module store
+  // Insert the module into the module store, it is never unloaded since
+  // functions of the shared object may still be referenced from script
   modules_.insert(ModulePair(module->GetFileName(), module));
+  resident_.insert(module->GetFileName());
   return module;
 }
 
+void ModuleFactory::Touch(ModulePointer module) {
+  if (resident_.end() != resident_.find(module->GetFileName())) {
+    return;
+  }
+  ModulePositionMap::iterator position =
+    positions_.find(module->GetFileName());
+  if (positions_.end() != position) {
+    lru_.splice(lru_.begin(), lru_, (*position).second);
+  } else {
+    lru_.push_front(module->GetFileName());
+    positions_[module->GetFileName()] = lru_.begin();
+  }
+}
+
+bool ModuleFactory::Unload(const char* file_name) {
+  ModuleMap::iterator iter = modules_.find(file_name);
+  if (modules_.end() == iter) {
+    return false;
+  }
+  // Only the module store may hold a reference
+  if (!(*iter).second.unique()) {
+    return false;
+  }
+  ModulePositionMap::iterator position = positions_.find(file_name);
+  if (positions_.end() == position) {
+    // The main module and native modules are never touched
+    return false;
+  }
+  lru_.erase((*position).second);
+  positions_.erase(position);
+  modules_.erase(iter);
+  return true;
+}
+
+void ModuleFactory::Evict(size_t max_modules) {
+  ModuleList::iterator iter = lru_.end();
+  while (modules_.size() > max_modules && lru_.begin() != iter) {
+    std::string file_name(*--iter);
+    ModuleList::iterator next = iter;
+    ++next;
+    if (Unload(file_name.c_str())) {
+      // The element iter referred to has been removed
+      iter = next;
+    }
+  }
+}
+
 ModulePointer ModuleFactory::NewModule(const char* id, const char* path) {
+  ModulePointer module;
+  // Skip directories that do not contain the module
+  if (directory_cache_ && !directory_cache_->MayContain(path, id)) {
+    return module;
+  }
+  // IDs with a '.json' suffix name JSON modules
+  std::string name(id);
+  if (name.length() > 5
+      && 0 == name.compare(name.length() - 5, 5, ".json")) {
+    return NewJsonModule(id, path);
+  }
   // Try to load a script module
-  ModulePointer module = NewScriptModule(id, path);
+  module = NewScriptModule(id, path);
   if (module.get()) {
     return module;
   }
@@ -33,15 +33,23 @@
 #define MOKA_MODULE_FACTORY_H
 
 #include <climits>
+#include <list>
 #include <map>
+#include "moka/bundle.h"
 #include "moka/script-module.h"
+#include <set>
 #include <tr1/memory>
 
 namespace moka {
 
 namespace internal {
 
+class CodeCache;
+class DirectoryCache;
 class ModuleFactory;
+class Prefetcher;
+class Preloader;
+class Tracer;
 
 typedef std::tr1::shared_ptr<Module> ModulePointer;
 
@@ -49,6 +57,12 @@ typedef std::pair<std::string, ModulePointer> ModulePair;
 
 typedef std::map<std::string, ModulePointer> ModuleMap;
 
+typedef std::list<std::string> ModuleList;
+
+typedef std::map<std::string, ModuleList::iterator> ModulePositionMap;
+
+typedef std::set<std::string> ModuleSet;
+
 } // namespace internal
 
 } // namespace moka
@@ -64,9 +78,33 @@ public:
    * \param module [in] The main module object
    * \param argc [in] A pointer to the application argument count
    * \param argc [in] A pointer to the application argument vector
+   * \param code_cache [in] The code cache used to compile script modules
+   * \param context [in] If not empty, script modules are evaluated in this
+   *                     shared context instead of a context of their own
+   *                     (the module loader owns the persistent handle)
+   * \param json_parse [in] The 'JSON.parse' function JSON modules are
+   *                       parsed with (owned by the module loader)
+   * \param json_freeze [in] The 'Object.freeze' function JSON modules are
+   *                        frozen with (owned by the module loader)
+   * \param bundle [in] If not NULL, script modules are looked up in this
+   *                    bundle before the file system is searched
+   * \param prefetcher [in] If not NULL, script modules are claimed from
+   *                        this prefetcher and scanned for dependencies
+   * \param preloader [in] If not NULL, shared object modules are claimed
+   *                       from this preloader before they are opened
+   * \param directory_cache [in] If not NULL, directories are checked
+   *                             against this cache before they are
+   *                             searched
+   * \param tracer [in] If not NULL, loading phases are recorded in this
+   *                    tracer
    */
   ModuleFactory(bool secure, v8::Handle<v8::Object> require,
-      ModulePointer module, int* argc, char*** argv);
+      ModulePointer module, int* argc, char*** argv, CodeCache* code_cache,
+      v8::Persistent<v8::Context> context,
+      v8::Persistent<v8::Function> json_parse,
+      v8::Persistent<v8::Function> json_freeze, BundlePointer bundle,
+      Prefetcher* prefetcher, Preloader* preloader,
+      DirectoryCache* directory_cache, Tracer* tracer);
 
   /// \brief Default destructor
   ~ModuleFactory() {}
@@ -97,6 +135,53 @@ public:
    */
   ModulePointer NewScriptModule(const char* id, const char* path);
 
+  /**
+   * \brief Construct a new module from a JSON file
+   *
+   * \param id [in] The ID of the module to be constructed, ending in
+   *                '.json'
+   * \param path [in] The path to search in for the module
+   *
+   * \return If the module was found, this function returns a pointer
+   *         to the new module. If the module was not found NULL is
+   *         returned. The return value can be checked with
+   *         std::tr1::shared_ptr::get().
+   */
+  ModulePointer NewJsonModule(const char* id, const char* path);
+
+  /**
+   * \brief Construct a new built-in module
+   *
+   * Built-in modules are native modules linked into the Moka library,
+   * see MOKA_BUILTIN_MODULE(). They are named "builtin:<id>".
+   *
+   * \param id [in] The top-level ID of the module to be constructed
+   *
+   * \return If the module is built in, this function returns a pointer
+   *         to the new module. If the module was not found NULL is
+   *         returned. The return value can be checked with
+   *         std::tr1::shared_ptr::get().
+   */
+  ModulePointer NewBuiltinModule(const char* id);
+
+  /**
+   * \brief Construct a new module from the bundle
+   *
+   * Modules in the bundle behave as if the bundle were a directory, so
+   * relative module IDs are resolved against the directory of a module
+   * that was itself loaded from the bundle.
+   *
+   * \param id [in] The ID of the module to be constructed
+   * \param path [in] The directory of the calling module for relative
+   *                  IDs, NULL for top-level IDs
+   *
+   * \return If the module was found, this function returns a pointer
+   *         to the new module. If the module was not found NULL is
+   *         returned. The return value can be checked with
+   *         std::tr1::shared_ptr::get().
+   */
+  ModulePointer NewBundleModule(const char* id, const char* path);
+
   /**
    * \brief Construct a new module from a shared library
    *
@@ -110,6 +195,23 @@ public:
    */
   ModulePointer NewSoModule(const char* id, const char* path);
 
+  /**
+   * \brief Look up a previously loaded module
+   *
+   * \param file_name [in] The absolute path of the module
+   *
+   * \return If the module is in the module store, this function returns
+   *         a pointer to it. Otherwise NULL is returned. The return value
+   *         can be checked with std::tr1::shared_ptr::get().
+   */
+  ModulePointer GetModule(const char* file_name) {
+    ModuleMap::iterator iter = modules_.find(file_name);
+    if (modules_.end() != iter) {
+      return (*iter).second;
+    }
+    return ModulePointer();
+  }
+
   /**
    * \brief Remove a module from the module store
    *
@@ -127,8 +229,51 @@ public:
     if (modules_.end() != iter) {
       modules_.erase(iter);
     }
+    ModulePositionMap::iterator position =
+      positions_.find(module->GetFileName());
+    if (positions_.end() != position) {
+      lru_.erase((*position).second);
+      positions_.erase(position);
+    }
   }
 
+  /**
+   * \brief Mark a module as the most recently used module
+   *
+   * Only modules that have been touched are candidates for eviction. The
+   * main module and native modules never are.
+   *
+   * \param module [in] A module in the module store
+   */
+  void Touch(ModulePointer module);
+
+  /**
+   * \brief Unload a module
+   *
+   * The module is removed from the module store and destroyed, releasing
+   * its context. It is loaded again (with new exports) when it is next
+   * required. Modules referenced outside of the module store, i.e., the
+   * main module and modules that are being loaded, can not be unloaded.
+   * Neither can shared object and built-in modules: their exports call
+   * into code that must stay mapped as long as scripts reference them.
+   *
+   * \param file_name [in] The absolute path of the module
+   *
+   * \return This function returns true if the module was unloaded, false
+   *         if it is not in the module store or still referenced.
+   */
+  bool Unload(const char* file_name);
+
+  /**
+   * \brief Unload the least recently used modules
+   *
+   * Modules are unloaded, least recently used first, until no more than
+   * max_modules modules remain or no module can be unloaded.
+   *
+   * \param max_modules [in] The number of modules to keep
+   */
+  void Evict(size_t max_modules);
+
 private: // non-copyable/instantiable
   ModuleFactory(Module const& that);
 
@@ -139,7 +284,19 @@ private: // private data
   v8::Persistent<v8::Object> require_;
   int* argc_;
   char*** argv_;
+  CodeCache* code_cache_;
+  v8::Persistent<v8::Context> context_;
+  v8::Persistent<v8::Function> json_parse_;
+  v8::Persistent<v8::Function> json_freeze_;
+  BundlePointer bundle_;
+  Prefetcher* prefetcher_;
+  Preloader* preloader_;
+  DirectoryCache* directory_cache_;
+  Tracer* tracer_;
   ModuleMap modules_;
+  ModuleList lru_;
+  ModulePositionMap positions_;
+  ModuleSet resident_;
   char resolved_path_[PATH_MAX];
 };
 
@@ -35,26 +35,65 @@
 #include <climits>
 #include <cstdlib>
 #include <cstring>
+#include <dlfcn.h>
+#include "moka/builtin.h"
+#include "moka/bundle.h"
+#include "moka/code-cache.h"
+#include "moka/directory-cache.h"
 #include "moka/module-factory.h"
 #include "moka/module-loader.h"
+#include "moka/prefetcher.h"
+#include "moka/preloader.h"
+#include "moka/script-source.h"
+#include "moka/symbols.h"
+#include "moka/tracer.h"
+#include "moka/watchdog.h"
 #include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include <unistd.h>
+#include <vector>
 
 namespace moka {
 
 ModuleLoader::ModuleLoader()
   : error_("None")
   , initialized_(false)
-  , secure_(false) {}
+  , secure_(false)
+  , shared_(false)
+  , prefetch_(false)
+  , preload_now_(false)
+  , max_modules_(0)
+  , time_limit_(0)
+  , cpu_limit_(0)
+  , heap_limit_(0)
+  , directory_cache_ttl_(2)
+  , isolate_(NULL) {}
 
 ModuleLoader::ModuleLoader(bool secure)
   : error_("None")
   , initialized_(false)
-  , secure_(secure) {}
+  , secure_(secure)
+  , shared_(false)
+  , prefetch_(false)
+  , preload_now_(false)
+  , max_modules_(0)
+  , time_limit_(0)
+  , cpu_limit_(0)
+  , heap_limit_(0)
+  , directory_cache_ttl_(2)
+  , isolate_(NULL) {}
 
 ModuleLoader::~ModuleLoader() {
   require_.Dispose();
+  context_.Dispose();
+  json_parse_.Dispose();
+  json_freeze_.Dispose();
   paths_.Dispose();
+  paths_snapshot_.Dispose();
+  if (isolate_) {
+    internal::Symbols::Release(isolate_);
+  }
 }
 
 /**
@@ -99,6 +138,29 @@ static char* NewId(const char* file_name) {
   return base_name_copy;
 }
 
+/**
+ * \brief Get a function of a global object
+ *
+ * \param object_name [in] The name of the global object, e.g., "JSON"
+ * \param name [in] The name of the function, e.g., "parse"
+ *
+ * \return The function or an empty handle if it does not exist.
+ */
+static v8::Local<v8::Function> GetGlobalFunction(const char* object_name,
+    const char* name) {
+  v8::Local<v8::Value> object = v8::Context::GetCurrent()->Global()->Get(
+      v8::String::NewSymbol(object_name));
+  if (object.IsEmpty() || !object->IsObject()) {
+    return v8::Local<v8::Function>();
+  }
+  v8::Local<v8::Value> function =
+    object->ToObject()->Get(v8::String::NewSymbol(name));
+  if (function.IsEmpty() || !function->IsFunction()) {
+    return v8::Local<v8::Function>();
+  }
+  return v8::Local<v8::Function>::Cast(function);
+}
+
 bool ModuleLoader::Initialize(const char* file_name) {
   return Initialize(file_name, NULL, NULL);
 }
@@ -109,11 +171,37 @@ bool ModuleLoader::Initialize(const char* file_name, int* argc, char*** argv) {
     // Already initialized
     return true;
   }
-  context_ = v8::Context::GetEntered();
-  if (context_.IsEmpty()) {
+  // Start tracing before anything is loaded
+  if (!trace_file_name_.empty()) {
+    tracer_.reset(new internal::Tracer(trace_file_name_.c_str()));
+  }
+  v8::Local<v8::Context> context = v8::Context::GetEntered();
+  if (context.IsEmpty()) {
     error_.assign("No currently entered context");
     return false;
   }
+  // Keep the context beyond this handle scope, the main module and shared
+  // mode modules run in it
+  context_.Dispose();
+  context_ = v8::Persistent<v8::Context>::New(context);
+  // JSON modules are parsed and frozen with the functions of the context
+  // as it was before any script ran, scripts can not replace them
+  v8::Local<v8::Function> json_parse = GetGlobalFunction("JSON", "parse");
+  v8::Local<v8::Function> json_freeze =
+    GetGlobalFunction("Object", "freeze");
+  if (json_parse.IsEmpty() || json_freeze.IsEmpty()) {
+    error_.assign("Failed to find JSON.parse and Object.freeze");
+    return false;
+  }
+  json_parse_.Dispose();
+  json_parse_ = v8::Persistent<v8::Function>::New(json_parse);
+  json_freeze_.Dispose();
+  json_freeze_ = v8::Persistent<v8::Function>::New(json_freeze);
+  // Keep the interned names of the isolate while the loader is alive
+  if (!isolate_) {
+    isolate_ = v8::Isolate::GetCurrent();
+    internal::Symbols::Acquire(isolate_);
+  }
   // Create 'require' object
   v8::Handle<v8::ObjectTemplate> require_templ = v8::ObjectTemplate::New();
   require_templ->SetInternalFieldCount(1);
@@ -152,11 +240,79 @@ bool ModuleLoader::Initialize(const char* file_name, int* argc, char*** argv) {
   if (!secure_) {
     require_templ->Set(v8::String::NewSymbol("paths"), paths_,
         static_cast<v8::PropertyAttribute>(v8::ReadOnly | v8::DontDelete));
+    require_templ->Set(v8::String::NewSymbol("unload"),
+        v8::FunctionTemplate::New(Unload, v8::External::New(this)),
+        static_cast<v8::PropertyAttribute>(v8::ReadOnly | v8::DontDelete));
   }
   // Export the 'require' object
   v8::Local<v8::Object> require = require_templ->NewInstance();
   require->SetInternalField(0, v8::External::New(this));
   require_ = v8::Persistent<v8::Object>::New(require);
+  // Create the code cache
+  code_cache_.reset(new internal::CodeCache(cache_directory_.c_str()));
+  if (!code_cache_.get()) {
+    error_.assign("No memory");
+    return false;
+  }
+  // Open the bundle
+  if (!bundle_file_name_.empty()) {
+    bundle_ = internal::Bundle::Open(bundle_file_name_.c_str());
+    if (!bundle_.get()) {
+      char error[BUFSIZ];
+      ::strerror_r(errno, error, BUFSIZ);
+      error_.assign(bundle_file_name_);
+      error_.append(": ");
+      error_.append(error);
+      return false;
+    }
+  }
+  // Start the watchdog
+  if (time_limit_ || cpu_limit_ || heap_limit_) {
+    watchdog_.reset(new internal::Watchdog(time_limit_, cpu_limit_,
+          heap_limit_));
+    if (!watchdog_.get() || !watchdog_->Start()) {
+      error_.assign("Failed to start the watchdog");
+      return false;
+    }
+  }
+  // Create the directory cache
+  if (directory_cache_ttl_ > 0) {
+    directory_cache_.reset(new internal::DirectoryCache(
+          directory_cache_ttl_));
+  }
+  // Start the prefetcher
+  if (prefetch_ && !secure_) {
+    prefetcher_.reset(new internal::Prefetcher(code_cache_.get(), bundle_,
+          shared_));
+    if (prefetcher_.get() && prefetcher_->Start()) {
+      UpdatePaths();
+    } else {
+      prefetcher_.reset();
+    }
+  }
+  // Open shared object modules while the main module is compiled
+  if (!preload_ids_.empty()) {
+    std::vector<std::string> ids;
+    for (std::vector<std::string>::iterator iter = preload_ids_.begin();
+        iter != preload_ids_.end(); ++iter) {
+      if (!iter->empty() && '.' != (*iter)[0]
+          && !internal::Builtin::Find(*iter)) {
+        ids.push_back(*iter);
+      }
+    }
+    std::vector<std::string> paths;
+    for (uint32_t index = 0; index < paths_->Length(); ++index) {
+      v8::Local<v8::Value> path_value = paths_->Get(index);
+      if (path_value->IsString()) {
+        paths.push_back(*v8::String::Utf8Value(path_value));
+      }
+    }
+    preloader_.reset(new internal::Preloader(ids, paths,
+          preload_now_ ? RTLD_NOW : RTLD_LAZY));
+    if (!preloader_.get() || !preloader_->Start()) {
+      preloader_.reset();
+    }
+  }
   // Create the 'main' module
   char resolved_path[PATH_MAX];
   if (!realpath(file_name, resolved_path)) {
@@ -165,27 +321,71 @@ bool ModuleLoader::Initialize(const char* file_name, int* argc, char*** argv) {
     error_.assign(error);
     return false;
   }
+  FILE* file = ::fopen(resolved_path, "rb");
+  if (!file) {
+    char error[BUFSIZ];
+    ::strerror_r(errno, error, BUFSIZ);
+    error_.assign(error);
+    return false;
+  }
+  struct stat buf;
+  if (::fstat(fileno(file), &buf)) {
+    char error[BUFSIZ];
+    ::strerror_r(errno, error, BUFSIZ);
+    error_.assign(error);
+    ::fclose(file);
+    return false;
+  }
+  if (!S_ISREG(buf.st_mode)) {
+    error_.assign("'");
+    error_.append(file_name);
+    error_.append("' is not a regular file");
+    ::fclose(file);
+    return false;
+  }
+  internal::ScriptSource* source =
+    new internal::FileSource(file, buf.st_size, buf.st_mtime);
+  if (!source) {
+    error_.assign("No memory");
+    ::fclose(file);
+    return false;
+  }
   ModulePointer module;
   char* id = NewId(resolved_path);
   if (id) {
-    module.reset(new Module(id, resolved_path, secure_, require_, context_));
+    module.reset(new internal::ScriptModule(id, resolved_path, secure_,
+          require_, context_, source, code_cache_.get(), tracer_.get()));
     ::free(id);
   } else {
-    module.reset(new Module(".", resolved_path, secure_, require_, context_));
+    module.reset(new internal::ScriptModule(".", resolved_path, secure_,
+          require_, context_, source, code_cache_.get(), tracer_.get()));
   }
   if (!module.get()) {
     error_.assign("No memory");
+    delete source;
     return false;
   }
   if (!module->Initialize()) {
     error_.assign("Failed to initialize main module");
     return false;
   }
+  if (prefetcher_.get()) {
+    // The main module is read here, only scan it for dependencies
+    delete prefetcher_->Take(resolved_path);
+    prefetcher_->Scan(resolved_path);
+  }
   // Store this module on the module stack for relative loading
   module_stack_.push(module);
   // Create the module factory
+  v8::Persistent<v8::Context> shared_context;
+  if (shared_ && !secure_) {
+    shared_context = context_;
+  }
   module_factory_.reset(new internal::ModuleFactory(secure_, require_, module,
-        argc, argv));
+        argc, argv, code_cache_.get(), shared_context, json_parse_,
+        json_freeze_, bundle_,
+        prefetcher_.get(), preloader_.get(), directory_cache_.get(),
+        tracer_.get()));
   if (!module_factory_.get()) {
     error_.assign("No Memory");
     return false;
@@ -197,6 +397,91 @@ bool ModuleLoader::Initialize(const char* file_name, int* argc, char*** argv) {
   return true;
 }
 
+const char* ModuleLoader::GetTerminationReason() const {
+  return watchdog_.get() ? watchdog_->GetReason() : NULL;
+}
+
+uint32_t ModuleLoader::GetCacheHits() const {
+  return code_cache_.get() ? code_cache_->GetHits() : 0;
+}
+
+uint32_t ModuleLoader::GetCacheMisses() const {
+  return code_cache_.get() ? code_cache_->GetMisses() : 0;
+}
+
+bool ModuleLoader::UpdatePaths() {
+  uint32_t length = paths_->Length();
+  if (!paths_snapshot_.IsEmpty() && paths_snapshot_->Length() == length) {
+    uint32_t index = 0;
+    while (index < length
+        && paths_->Get(index)->StrictEquals(paths_snapshot_->Get(index))) {
+      ++index;
+    }
+    if (index == length) {
+      return false;
+    }
+  }
+  // Take a new snapshot of 'paths'
+  v8::HandleScope handle_scope;
+  v8::Local<v8::Array> snapshot = v8::Array::New(length);
+  for (uint32_t index = 0; index < length; ++index) {
+    snapshot->Set(index, paths_->Get(index));
+  }
+  paths_snapshot_.Dispose();
+  paths_snapshot_ = v8::Persistent<v8::Array>::New(snapshot);
+  if (prefetcher_.get()) {
+    std::vector<std::string> paths;
+    for (uint32_t index = 0; index < length; ++index) {
+      v8::Local<v8::Value> path_value = snapshot->Get(index);
+      if (path_value->IsString()) {
+        paths.push_back(*v8::String::Utf8Value(path_value));
+      }
+    }
+    prefetcher_->SetPaths(paths);
+  }
+  return true;
+}
+
+v8::Handle<v8::Value> ModuleLoader::Run() {
+  if (!initialized_) {
+    return v8::ThrowException(
+        v8::String::New("Module loader is not initialized"));
+  }
+  // Outside of 'require' the main module is the only module on the stack
+  ModulePointer module = module_stack_.top();
+  internal::Tracer::Scope trace(tracer_.get(), "require", "main",
+      module->GetFileName());
+  internal::Watchdog::Scope watchdog(watchdog_.get());
+  return module->Load();
+}
+
+v8::Handle<v8::Value> ModuleLoader::Run(v8::Handle<v8::Script> script) {
+  internal::Watchdog::Scope watchdog(watchdog_.get());
+  return script->Run();
+}
+
+/**
+ * \brief Check if a module ID is relative
+ *
+ * \param id [in] A module ID
+ *
+ * \return This function returns true if id starts with './' or '../',
+ *         false otherwise.
+ */
+static bool IsRelative(const std::string& id) {
+  if (id.length() > 1) {
+    if ('.' == id[0] && '/' == id[1]) {
+      return true;
+    }
+  }
+  if (id.length() > 2) {
+    if ('.' == id[0] && '.' == id[1] && '/' == id[2]) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * \brief This function implements the 'require' function
  *
@@ -231,49 +516,85 @@ v8::Handle<v8::Value> ModuleLoader::Require(const v8::Arguments& arguments) {
     return v8::ThrowException(
         v8::String::New("Module loader is not initialized"));
   }
+  // Trace this require as a child of the calling module
+  internal::Tracer* tracer = module_loader->tracer_.get();
+  internal::Tracer::Scope trace(tracer, "require", id.c_str(), NULL,
+      module_loader->module_stack_.top()->GetFileName());
+  internal::Tracer::Scope resolve_trace(tracer, "phase", "resolve");
   // Determine if this is a relative path
-  bool relative = false;
-  if (id.length() > 1) {
-    if ('.' == id[0] && '/' == id[1]) {
-      relative = true;
+  bool relative = IsRelative(id);
+  // Relative requires are resolved from the calling module's directory,
+  // skip these in secure mode
+  const char* directory_name = NULL;
+  if (relative && !module_loader->secure_) {
+    // Get the calling module
+    ModulePointer previous_module = module_loader->module_stack_.top();
+    if (!previous_module.get()) {
+      return v8::ThrowException(
+          v8::String::New("Internal module loader error"));
     }
-  }
-  if (id.length() > 2) {
-    if ('.' == id[0] && '.' == id[1] && '/' == id[2]) {
-      relative = true;
+    // Get the source directory for the calling module
+    directory_name = previous_module->GetDirectoryName();
+    if (!directory_name) {
+      return v8::ThrowException(Module::ErrnoException::New(ENOMEM));
     }
   }
-  // Attempt to find the module
+  // Built-in modules are found without a search
   ModulePointer module;
   if (!relative) {
-    // Normal require, search through stored paths
-    v8::Local<v8::Array> properties = module_loader->paths_->GetPropertyNames();
-    uint32_t index = 0, length = properties->Length();
-    while ((index < length) && !module.get()) {
-      v8::Local<v8::Value> path_value =
-        module_loader->paths_->Get(properties->Get(index++));
-      if (path_value->IsString()) {
-        module = module_loader->module_factory_->NewModule(id.c_str(),
-            *v8::String::Utf8Value(path_value));
-      }
+    module = module_loader->module_factory_->NewBuiltinModule(id.c_str());
+  }
+  if (!module.get()) {
+    // Consult the resolution cache, it is only valid for the current paths
+    if (module_loader->UpdatePaths()) {
+      module_loader->resolutions_.clear();
     }
-  } else {
-    // Relative require, skip these in secure mode
-    if (!module_loader->secure_) {
-      // Get the calling module
-      ModulePointer previous_module = module_loader->module_stack_.top();
-      if (!previous_module.get()) {
-        return v8::ThrowException(
-            v8::String::New("Internal module loader error"));
+    std::string key(directory_name ? directory_name : "");
+    key.append(1, '\0');
+    key.append(id);
+    ResolutionMap::iterator iter = module_loader->resolutions_.find(key);
+    if (module_loader->resolutions_.end() != iter) {
+      if (iter->second.empty()) {
+        // Cached negative result
+        std::string error("No module named ");
+        error.append(id);
+        return v8::ThrowException(v8::String::New(error.c_str()));
       }
-      // Get the source directory for the calling module
-      const char* directory_name = previous_module->GetDirectoryName();
-      if (!directory_name) {
-        return v8::ThrowException(Module::ErrnoException::New(ENOMEM));
+      // If the module was since removed from the module store fall back
+      // to a full search
+      module = module_loader->module_factory_->GetModule(
+          iter->second.c_str());
+    }
+    if (!module.get()) {
+      if (!relative) {
+        // Normal require, consult the bundle then search through stored
+        // paths
+        module = module_loader->module_factory_->NewBundleModule(id.c_str(),
+            NULL);
+        if (module_loader->directory_cache_.get()) {
+          module_loader->directory_cache_->Refresh();
+        }
+        uint32_t index = 0, length = module_loader->paths_->Length();
+        while ((index < length) && !module.get()) {
+          v8::Local<v8::Value> path_value =
+            module_loader->paths_->Get(index++);
+          if (path_value->IsString()) {
+            module = module_loader->module_factory_->NewModule(id.c_str(),
+                *v8::String::Utf8Value(path_value));
+          }
+        }
+      } else if (directory_name) {
+        // Load the new module relative to the current one
+        module = module_loader->module_factory_->NewBundleModule(id.c_str(),
+            directory_name);
+        if (!module.get()) {
+          module = module_loader->module_factory_->NewModule(id.c_str(),
+              directory_name);
+        }
       }
-      // Load the new module relative to the current one
-      module = module_loader->module_factory_->NewModule(id.c_str(),
-          directory_name);
+      // Store the result, including a negative one
+      module_loader->resolutions_[key] =
+        module.get() ? module->GetFileName() : "";
     }
   }
   if (!module.get()) {
@@ -282,7 +603,12 @@ v8::Handle<v8::Value> ModuleLoader::Require(const v8::Arguments& arguments) {
     error.append(id);
     return v8::ThrowException(v8::String::New(error.c_str()));
   }
+  trace.SetModule(module->GetFileName());
+  resolve_trace.SetModule(module->GetFileName());
+  resolve_trace.End();
+  module_loader->module_factory_->Touch(module);
   // The requested module was found, store it on the module stack
+  internal::Watchdog::Scope watchdog(module_loader->watchdog_.get());
   module_loader->module_stack_.push(module);
   // Attempt to load the module
   v8::Handle<v8::Value> exports = module->Load();
@@ -291,6 +617,10 @@ v8::Handle<v8::Value> ModuleLoader::Require(const v8::Arguments& arguments) {
   if (exports.IsEmpty()) {
     // Failure, remove the module from the module store
     module_loader->module_factory_->RemoveModule(module);
+    if (v8::V8::IsExecutionTerminating()) {
+      // Let termination unwind to the embedder
+      return exports;
+    }
     std::string error("Failed to load module ");
     error.append(id);
     return v8::ThrowException(v8::String::New(error.c_str()));
@@ -299,10 +629,69 @@ v8::Handle<v8::Value> ModuleLoader::Require(const v8::Arguments& arguments) {
     module_loader->module_factory_->RemoveModule(module);
     return exports;
   }
-  // Successfully loaded, return exports
+  // Successfully loaded, unload the least recently used modules
+  if (module_loader->max_modules_) {
+    module_loader->module_factory_->Evict(module_loader->max_modules_);
+  }
   return exports;
 }
 
+/**
+ * \brief This function implements the 'require.unload' function
+ *
+ * JavaScript calling this function should pass a module ID that has been
+ * required from the calling module (or the absolute path of a module).
+ * The module is unloaded and loaded again when it is next required.
+ *
+ * \param arguments [in] JavaScript arguments
+ *
+ * \return This function returns true if the module was unloaded, false
+ *         if it is not loaded or is in use. If an error occurs then this
+ *         function will throw a JavaScript exception.
+ */
+v8::Handle<v8::Value> ModuleLoader::Unload(const v8::Arguments& arguments) {
+  // Check the number of arguments
+  if (arguments.Length() != 1) {
+    return v8::ThrowException(v8::String::New("A single argument is required"));
+  }
+  // Verify that argument one is a string
+  if (!arguments[0]->IsString()) {
+    return v8::ThrowException(v8::String::New("Argument one must be a string"));
+  }
+  // Get the ModuleLoader pointer, i.e., 'this'
+  std::string id(*v8::String::Utf8Value(arguments[0]));
+  v8::Local<v8::External> external =
+    v8::Local<v8::External>::Cast(arguments.Data());
+  ModuleLoader* module_loader = static_cast<ModuleLoader*>(external->Value());
+  if (!module_loader->initialized_) {
+    return v8::ThrowException(
+        v8::String::New("Module loader is not initialized"));
+  }
+  // Find the module the way 'require' resolved it
+  const char* directory_name = NULL;
+  if (IsRelative(id)) {
+    directory_name = module_loader->module_stack_.top()->GetDirectoryName();
+    if (!directory_name) {
+      return v8::ThrowException(Module::ErrnoException::New(ENOMEM));
+    }
+  }
+  std::string key(directory_name ? directory_name : "");
+  key.append(1, '\0');
+  key.append(id);
+  std::string file_name;
+  ResolutionMap::iterator iter = module_loader->resolutions_.find(key);
+  if (module_loader->resolutions_.end() != iter) {
+    file_name = iter->second;
+  } else if (!id.empty() && '/' == id[0]) {
+    file_name = id;
+  }
+  if (file_name.empty()) {
+    return v8::False();
+  }
+  return v8::Boolean::New(
+      module_loader->module_factory_->Unload(file_name.c_str()));
+}
+
 } // namespace moka
 
 // vim: tabstop=2:sw=2:expandtab
@@ -33,11 +33,14 @@
 #ifndef MOKA_MODULE_LOADER_H
 #define MOKA_MODULE_LOADER_H
 
+#include <ctime>
+#include <map>
 #include <moka/macros.h>
 #include <stack>
 #include <string>
 #include <tr1/memory>
 #include <v8.h>
+#include <vector>
 
 namespace moka {
 
@@ -46,7 +49,14 @@ class Module;
 
 namespace internal {
 
+class Bundle;
+class CodeCache;
+class DirectoryCache;
 class ModuleFactory;
+class Prefetcher;
+class Preloader;
+class Tracer;
+class Watchdog;
 
 } // namespace internal
 
@@ -54,8 +64,24 @@ typedef std::tr1::shared_ptr<Module> ModulePointer;
 
 typedef std::tr1::shared_ptr<internal::ModuleFactory> ModuleFactoryPointer;
 
+typedef std::tr1::shared_ptr<internal::CodeCache> CodeCachePointer;
+
+typedef std::tr1::shared_ptr<internal::Bundle> BundlePointer;
+
+typedef std::tr1::shared_ptr<internal::Prefetcher> PrefetcherPointer;
+
+typedef std::tr1::shared_ptr<internal::Preloader> PreloaderPointer;
+
+typedef std::tr1::shared_ptr<internal::DirectoryCache> DirectoryCachePointer;
+
+typedef std::tr1::shared_ptr<internal::Tracer> TracerPointer;
+
+typedef std::tr1::shared_ptr<internal::Watchdog> WatchdogPointer;
+
 typedef std::stack<ModulePointer> ModuleStack;
 
+typedef std::map<std::string, std::string> ResolutionMap;
+
 } // namespace moka
 
 /// A CommonJS 1.1 module loader
@@ -117,6 +143,235 @@ public:
    */
   bool Initialize(const char* file_name, int* argc, char*** argv);
 
+  /**
+   * \brief Set the code cache directory
+   *
+   * If a cache directory is set, compilation data for script modules
+   * (including the main program script) is stored in and loaded from this
+   * directory. This function must be called before the module loader is
+   * initialized.
+   *
+   * \param directory [in] An existing, writable directory
+   */
+  void SetCacheDirectory(const char* directory) {
+    cache_directory_.assign(directory ? directory : "");
+  }
+
+  /**
+   * \brief Evaluate script modules in the main context
+   *
+   * By default every module is evaluated in a V8 context of its own. In
+   * shared context mode script modules are instead evaluated in the
+   * context the module loader was initialized in, wrapped in a function
+   * taking 'exports', 'require' and 'module'. This is considerably
+   * cheaper but modules share built-in objects and may see each other's
+   * globals. Shared object modules always receive a context of their own,
+   * and the setting is ignored by secure module loaders. This function
+   * must be called before the module loader is initialized.
+   *
+   * \param shared [in] Indicates if script modules share a context
+   */
+  void SetSharedContext(bool shared) {
+    shared_ = shared;
+  }
+
+  /**
+   * \brief Load script modules from a bundle
+   *
+   * A bundle packs many script modules into a single file (see the
+   * moka-pack utility). Top-level module IDs are looked up in the bundle
+   * before 'require.paths' is searched. This function must be called
+   * before the module loader is initialized.
+   *
+   * \param file_name [in] The file name of the bundle
+   */
+  void SetBundle(const char* file_name) {
+    bundle_file_name_.assign(file_name ? file_name : "");
+  }
+
+  /**
+   * \brief Set the lifetime of cached directory listings
+   *
+   * The directories in 'require.paths' are listed once and top-level
+   * module IDs are checked against the listings before a directory is
+   * searched. Listings are invalidated with inotify where possible,
+   * otherwise they expire after the given number of seconds (two by
+   * default). This function must be called before the module loader is
+   * initialized.
+   *
+   * \param ttl [in] The lifetime of a listing in seconds, zero disables
+   *                 the directory cache
+   */
+  void SetDirectoryCacheTtl(time_t ttl) {
+    directory_cache_ttl_ = ttl;
+  }
+
+  /**
+   * \brief Prefetch the dependencies of script modules
+   *
+   * If enabled, every script module is scanned for literal 'require'
+   * calls on a background thread. The modules found are resolved and
+   * read (along with their code cache entries) before they are required.
+   * The setting is ignored by secure module loaders. This function must
+   * be called before the module loader is initialized.
+   *
+   * \param prefetch [in] Indicates if dependencies are prefetched
+   */
+  void SetPrefetch(bool prefetch) {
+    prefetch_ = prefetch;
+  }
+
+  /**
+   * \brief Limit the number of resident modules
+   *
+   * If a limit is set, the least recently required script and JSON
+   * modules are unloaded once more modules are loaded, releasing their
+   * contexts. An unloaded module is loaded again, with new exports, when
+   * it is next required. The main module, modules that are being loaded
+   * and native (shared object and built-in) modules are never unloaded.
+   * Modules can also be unloaded explicitly with 'require.unload(id)'.
+   *
+   * \param max_modules [in] The maximum number of resident modules, zero
+   *                         (the default) for no limit
+   */
+  void SetMaxModules(size_t max_modules) {
+    max_modules_ = max_modules;
+  }
+
+  /**
+   * \brief Preload a shared object module
+   *
+   * Preloaded modules are resolved in 'require.paths' and opened on a
+   * background thread while the main script is compiled. Only top-level
+   * IDs of shared object modules may be preloaded, static constructors of
+   * the shared objects must not call into V8. This function must be
+   * called before the module loader is initialized.
+   *
+   * \param id [in] The top-level module ID, e.g., "io"
+   */
+  void AddPreload(const char* id) {
+    preload_ids_.push_back(id);
+  }
+
+  /**
+   * \brief Resolve all symbols of preloaded modules
+   *
+   * If enabled, preloaded shared objects are opened with RTLD_NOW, so no
+   * symbol is resolved lazily on the request path. This function must be
+   * called before the module loader is initialized.
+   *
+   * \param now [in] Indicates if symbols are resolved when preloading
+   */
+  void SetPreloadNow(bool now) {
+    preload_now_ = now;
+  }
+
+  /**
+   * \brief Trace module loading
+   *
+   * If a trace file is set, the time spent resolving, reading, compiling
+   * and running every module (or opening and initializing shared object
+   * modules) is recorded along with the module that required it. The
+   * trace is written in the Chrome trace event format when the module
+   * loader is destroyed. This function must be called before the module
+   * loader is initialized.
+   *
+   * \param file_name [in] The file the trace is written to
+   */
+  void SetTraceFile(const char* file_name) {
+    trace_file_name_.assign(file_name ? file_name : "");
+  }
+
+  /**
+   * \brief Limit the wall time of an execution
+   *
+   * An execution is a call to Run(), or a call to 'require' that is not
+   * made from within another execution. If an execution exceeds a limit
+   * it is terminated; termination can not be caught by scripts. The
+   * reason is available from GetTerminationReason(). This function must
+   * be called before the module loader is initialized.
+   *
+   * \param milliseconds [in] The wall time limit, zero (the default) for
+   *                          no limit
+   */
+  void SetTimeLimit(unsigned milliseconds) {
+    time_limit_ = milliseconds;
+  }
+
+  /**
+   * \brief Limit the CPU time of an execution
+   *
+   * See SetTimeLimit(). This function must be called before the module
+   * loader is initialized.
+   *
+   * \param milliseconds [in] The CPU time limit, zero (the default) for no
+   *                          limit
+   */
+  void SetCpuLimit(unsigned milliseconds) {
+    cpu_limit_ = milliseconds;
+  }
+
+  /**
+   * \brief Limit the growth of the V8 heap during an execution
+   *
+   * The heap in use is checked after each garbage collection against the
+   * heap in use when the execution started. See
+   * SetTimeLimit(). This function must be called before the module loader
+   * is initialized.
+   *
+   * \param bytes [in] The heap growth limit, zero (the default) for no
+   *                   limit
+   */
+  void SetHeapLimit(size_t bytes) {
+    heap_limit_ = bytes;
+  }
+
+  /**
+   * \brief Get the reason the last execution was terminated
+   *
+   * \return A description of the exceeded limit, e.g., "CPU limit
+   *         exceeded", or NULL if the last execution was not terminated.
+   */
+  const char* GetTerminationReason() const;
+
+  /**
+   * \brief Get the number of scripts compiled from the code cache
+   *
+   * \return The code cache hit count.
+   */
+  uint32_t GetCacheHits() const;
+
+  /**
+   * \brief Get the number of scripts compiled without the code cache
+   *
+   * \return The code cache miss count.
+   */
+  uint32_t GetCacheMisses() const;
+
+  /**
+   * \brief Run the main program script
+   *
+   * The script passed to Initialize() is compiled and run in the entered
+   * context.
+   *
+   * \return The exports of the main module. If an exception was thrown
+   *         an empty handle is returned.
+   */
+  v8::Handle<v8::Value> Run();
+
+  /**
+   * \brief Run a script under the limits of the module loader
+   *
+   * The script is run in the entered context as an execution, see
+   * SetTimeLimit().
+   *
+   * \param script [in] A compiled script
+   *
+   * \return The completion value of the script. If an exception was
+   *         thrown an empty handle is returned.
+   */
+  v8::Handle<v8::Value> Run(v8::Handle<v8::Script> script);
+
 private: // non-copyable
   ModuleLoader(ModuleLoader const& that);
 
@@ -125,15 +380,49 @@ private: // non-copyable
 private: // private methods
   static v8::Handle<v8::Value> Require(const v8::Arguments& args);
 
+  static v8::Handle<v8::Value> Unload(const v8::Arguments& args);
+
+  /**
+   * \brief Check 'require.paths' for modifications
+   *
+   * \return This function returns true if 'paths' changed since the last
+   *         call (the resolution cache must be discarded), false otherwise.
+   */
+  bool UpdatePaths();
+
 private: // private data
   std::string error_;
+  std::string trace_file_name_;
+  TracerPointer tracer_;
   bool initialized_;
   bool secure_;
-  v8::Handle<v8::Context> context_;
+  bool shared_;
+  bool prefetch_;
+  std::vector<std::string> preload_ids_;
+  bool preload_now_;
+  size_t max_modules_;
+  unsigned time_limit_;
+  unsigned cpu_limit_;
+  size_t heap_limit_;
+  WatchdogPointer watchdog_;
+  time_t directory_cache_ttl_;
+  std::string cache_directory_;
+  CodeCachePointer code_cache_;
+  std::string bundle_file_name_;
+  BundlePointer bundle_;
+  PrefetcherPointer prefetcher_;
+  PreloaderPointer preloader_;
+  DirectoryCachePointer directory_cache_;
+  v8::Persistent<v8::Context> context_;
   v8::Persistent<v8::Object> require_;
+  v8::Persistent<v8::Function> json_parse_;
+  v8::Persistent<v8::Function> json_freeze_;
   v8::Persistent<v8::Array> paths_;
+  v8::Persistent<v8::Array> paths_snapshot_;
+  ResolutionMap resolutions_;
   ModuleFactoryPointer module_factory_;
   ModuleStack module_stack_;
+  v8::Isolate* isolate_;
 };
 
 #endif // MOKA_MODULE_LOADER_H
@@ -39,18 +39,95 @@
 #include "moka/array-buffer.h"
 #include "moka/data-view.h"
 #include "moka/module.h"
+#include "moka/symbols.h"
 #include "moka/typed-array-view.h"
 
 namespace moka {
 
+/// \brief A function that is created on first access
+struct LazyFunction {
+  const char* name;
+  v8::Handle<v8::FunctionTemplate> (*get_template)();
+};
+
+static v8::Handle<v8::FunctionTemplate> GetInt8ArrayTemplate() {
+  return TypedArrayView<int8_t, v8::kExternalByteArray>::GetTemplate(
+      "Int8Array");
+}
+
+static v8::Handle<v8::FunctionTemplate> GetUint8ArrayTemplate() {
+  return TypedArrayView<uint8_t, v8::kExternalUnsignedByteArray>::GetTemplate(
+      "Uint8Array");
+}
+
+static v8::Handle<v8::FunctionTemplate> GetInt16ArrayTemplate() {
+  return TypedArrayView<int16_t, v8::kExternalShortArray>::GetTemplate(
+      "Int16Array");
+}
+
+static v8::Handle<v8::FunctionTemplate> GetUint16ArrayTemplate() {
+  return TypedArrayView<uint16_t,
+         v8::kExternalUnsignedShortArray>::GetTemplate("Uint16Array");
+}
+
+static v8::Handle<v8::FunctionTemplate> GetInt32ArrayTemplate() {
+  return TypedArrayView<int32_t, v8::kExternalIntArray>::GetTemplate(
+      "Int32Array");
+}
+
+static v8::Handle<v8::FunctionTemplate> GetUint32ArrayTemplate() {
+  return TypedArrayView<uint32_t, v8::kExternalUnsignedIntArray>::GetTemplate(
+      "Uint32Array");
+}
+
+static v8::Handle<v8::FunctionTemplate> GetFloat32ArrayTemplate() {
+  return TypedArrayView<float, v8::kExternalFloatArray>::GetTemplate(
+      "Float32Array");
+}
+
+static v8::Handle<v8::FunctionTemplate> GetDouble64ArrayTemplate() {
+  return TypedArrayView<double, v8::kExternalDoubleArray>::GetTemplate(
+      "Double64Array");
+}
+
+/**
+ * \brief Functions created on first access
+ *
+ * The first kGlobalFunctions entries are installed on the global object,
+ * the remaining entries on the 'module' object.
+ */
+static const LazyFunction kLazyFunctions[] = {
+  { "ArrayBuffer", ArrayBuffer::GetTemplate },
+  { "Int8Array", GetInt8ArrayTemplate },
+  { "Uint8Array", GetUint8ArrayTemplate },
+  { "Int16Array", GetInt16ArrayTemplate },
+  { "Uint16Array", GetUint16ArrayTemplate },
+  { "Int32Array", GetInt32ArrayTemplate },
+  { "Uint32Array", GetUint32ArrayTemplate },
+  { "Float32Array", GetFloat32ArrayTemplate },
+  { "Double64Array", GetDouble64ArrayTemplate },
+  { "DataView", DataView::GetTemplate },
+  { "Exception", Module::Exception::GetTemplate },
+  { "ErrnoException", Module::ErrnoException::GetTemplate }
+};
+
+/// \brief The number of lazy functions on the global object
+static const int kGlobalFunctions = 10;
+
+/// \brief The number of lazy functions
+static const int kLazyFunctionCount =
+  sizeof(kLazyFunctions) / sizeof(kLazyFunctions[0]);
+
 Module::Module(const char* id, const char* file_name, bool secure,
-    v8::Handle<v8::Object> require, v8::Handle<v8::Context> context)
+    v8::Handle<v8::Object> require, v8::Handle<v8::Context> context,
+    bool shared)
   : id_(id)
   , file_name_(file_name)
   , directory_name_(NULL)
   , secure_(secure)
   , initialized_(false)
   , context_owner_(false)
+  , shared_(shared)
   , context_(context)
   , require_(require) {}
 
@@ -62,7 +139,8 @@ Module::Module(const char* id, const char* file_name, bool secure,
   , secure_(secure)
   , initialized_(false)
   , context_owner_(true)
-  , context_(v8::Context::New())
+  , shared_(false)
+  , context_(v8::Context::New(NULL, GetGlobalTemplate(secure)))
   , require_(require) {}
 
 Module::~Module() {
@@ -82,54 +160,38 @@ bool Module::Initialize() {
     return true;
   }
   v8::Context::Scope scope(context_);
-  if (!secure_) {
-    // Add the print function for testing
-    v8::Local<v8::FunctionTemplate> print_templ =
-      v8::FunctionTemplate::New(Print);
-    context_->Global()->Set(v8::String::New("print"),
-        print_templ->GetFunction());
+  if (!shared_) {
+    // A shared context is set up by its owner
+    if (!context_owner_) {
+      // Contexts created by the embedder lack the built-in objects
+      if (!secure_) {
+        context_->Global()->Set(v8::String::NewSymbol("print"),
+            v8::FunctionTemplate::New(Print)->GetFunction());
+      }
+      for (int index = 0; index < kGlobalFunctions; ++index) {
+        context_->Global()->SetAccessor(
+            v8::String::NewSymbol(kLazyFunctions[index].name),
+            GetLazyFunction, SetLazyFunction, v8::Integer::New(index));
+      }
+    }
+    // Add the require object
+    context_->Global()->Set(
+        internal::Symbols::Get(internal::Symbols::kRequire), require_);
   }
-  // Add the TypedArray objects
-  context_->Global()->Set(v8::String::NewSymbol("ArrayBuffer"),
-      ArrayBuffer::GetTemplate()->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Int8Array"),
-      TypedArrayView<int8_t, v8::kExternalByteArray>::GetTemplate(
-        "Int8Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Uint8Array"),
-      TypedArrayView<uint8_t, v8::kExternalUnsignedByteArray>::GetTemplate(
-        "Uint8Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Int16Array"),
-      TypedArrayView<int16_t, v8::kExternalShortArray>::GetTemplate(
-        "Int16Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Uint16Array"),
-      TypedArrayView<uint16_t, v8::kExternalUnsignedShortArray>::GetTemplate(
-        "Uint16Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Int32Array"),
-      TypedArrayView<int32_t, v8::kExternalIntArray>::GetTemplate(
-        "Int32Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Uint32Array"),
-      TypedArrayView<uint32_t, v8::kExternalUnsignedIntArray>::GetTemplate(
-        "Uint32Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Float32Array"),
-      TypedArrayView<float, v8::kExternalFloatArray>::GetTemplate(
-        "Float32Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("Double64Array"),
-      TypedArrayView<double, v8::kExternalDoubleArray>::GetTemplate(
-        "Double64Array")->GetFunction());
-  context_->Global()->Set(v8::String::NewSymbol("DataView"),
-      DataView::GetTemplate()->GetFunction());
-  // Add the require object
-  context_->Global()->Set(v8::String::NewSymbol("require"), require_);
   // Initialize exports
   v8::Local<v8::Object> exports = v8::Object::New();
   // Store 'paths' as a persistent object
   exports_ = v8::Persistent<v8::Object>::New(exports);
-  // Create 'exports' object
-  context_->Global()->Set(v8::String::NewSymbol("exports"), exports_);
+  if (!shared_) {
+    // Create 'exports' object
+    context_->Global()->Set(
+        internal::Symbols::Get(internal::Symbols::kExports), exports_);
+  }
   // Initialize module
   v8::Local<v8::Object> module = v8::Object::New();
   // Create the 'id' property
-  module->Set(v8::String::NewSymbol("id"), v8::String::New(id_.c_str()),
+  module->Set(internal::Symbols::Get(internal::Symbols::kId),
+      v8::String::New(id_.c_str()),
       static_cast<v8::PropertyAttribute>(v8::ReadOnly | v8::DontDelete));
   if (!secure_) {
     // Create the 'uri' property
@@ -141,16 +203,54 @@ bool Module::Initialize() {
   // Store 'module' as a persistent object
   module_ = v8::Persistent<v8::Object>::New(module);
   // Create exceptions
-  module_->Set(v8::String::NewSymbol("Exception"),
-      Module::Exception::GetTemplate()->GetFunction());
-  module_->Set(v8::String::NewSymbol("ErrnoException"),
-      Module::ErrnoException::GetTemplate()->GetFunction());
-  // Create 'module' object
-  context_->Global()->Set(v8::String::NewSymbol("module"), module_);
+  for (int index = kGlobalFunctions; index < kLazyFunctionCount; ++index) {
+    module_->SetAccessor(v8::String::NewSymbol(kLazyFunctions[index].name),
+        GetLazyFunction, SetLazyFunction, v8::Integer::New(index));
+  }
+  if (!shared_) {
+    // Create 'module' object
+    context_->Global()->Set(
+        internal::Symbols::Get(internal::Symbols::kModule), module_);
+  }
   initialized_ = true;
   return true;
 }
 
+v8::Handle<v8::ObjectTemplate> Module::GetGlobalTemplate(bool secure) {
+  static v8::Persistent<v8::ObjectTemplate> templ_[2];
+  if (!templ_[secure].IsEmpty()) {
+    return templ_[secure];
+  }
+  v8::Local<v8::ObjectTemplate> templ = v8::ObjectTemplate::New();
+  if (!secure) {
+    // Add the print function for testing
+    templ->Set(v8::String::NewSymbol("print"),
+        v8::FunctionTemplate::New(Print));
+  }
+  // Add the TypedArray objects
+  for (int index = 0; index < kGlobalFunctions; ++index) {
+    templ->SetAccessor(v8::String::NewSymbol(kLazyFunctions[index].name),
+        GetLazyFunction, SetLazyFunction, v8::Integer::New(index));
+  }
+  templ_[secure] = v8::Persistent<v8::ObjectTemplate>::New(templ);
+  return templ_[secure];
+}
+
+v8::Handle<v8::Value> Module::GetLazyFunction(v8::Local<v8::String> name,
+    const v8::AccessorInfo& info) {
+  int index = info.Data()->Int32Value();
+  v8::Local<v8::Function> function =
+    kLazyFunctions[index].get_template()->GetFunction();
+  // Replace the accessor with the function
+  info.Holder()->ForceSet(name, function);
+  return function;
+}
+
+void Module::SetLazyFunction(v8::Local<v8::String> name,
+    v8::Local<v8::Value> value, const v8::AccessorInfo& info) {
+  info.Holder()->ForceSet(name, value);
+}
+
 v8::Handle<v8::Value> Module::Print(const v8::Arguments& args) {
   for (int i = 0; i < args.Length(); ++i) {
     if (i != 0) {
@@ -189,7 +289,7 @@ const char* Module::GetDirectoryName() {
 v8::Handle<v8::Value> Module::Require(v8::Handle<v8::String> name) {
   v8::HandleScope handle_scope;
   v8::Handle<v8::Value> require = v8::Context::GetCurrent()->Global()->
-    Get(v8::String::NewSymbol("require"));
+    Get(internal::Symbols::Get(internal::Symbols::kRequire));
   if (require.IsEmpty()) {
     // Should be unreachable
     return handle_scope.Close(v8::ThrowException(v8::Exception::Error(
@@ -208,7 +308,7 @@ v8::Handle<v8::Value> Module::Require(v8::Handle<v8::String> name) {
 v8::Handle<v8::Value> Module::Exports() {
   v8::HandleScope handle_scope;
   v8::Handle<v8::Value> exports = v8::Context::GetCurrent()->Global()->
-    Get(v8::String::NewSymbol("exports"));
+    Get(internal::Symbols::Get(internal::Symbols::kExports));
   if (exports.IsEmpty()) {
     // Should be unreachable
     return handle_scope.Close(v8::ThrowException(v8::Exception::Error(
@@ -237,13 +337,18 @@ v8::Handle<v8::Value> Module::ConstructCall(
 
 v8::Handle<v8::Value> Module::CallMethod(v8::Handle<v8::Object> object,
     const char* method, int argc, v8::Handle<v8::Value> argv[]) {
+  return CallMethod(object, v8::String::NewSymbol(method), argc, argv);
+}
+
+v8::Handle<v8::Value> Module::CallMethod(v8::Handle<v8::Object> object,
+    v8::Handle<v8::String> method, int argc, v8::Handle<v8::Value> argv[]) {
   v8::TryCatch try_catch;
-  v8::Handle<v8::Value> function = object->Get(v8::String::NewSymbol(method));
+  v8::Handle<v8::Value> function = object->Get(method);
   if (function.IsEmpty()) {
     return try_catch.ReThrow();
   }
   if (!function->IsFunction()) {
-    std::string message(method);
+    std::string message(*v8::String::Utf8Value(method));
     message.append(" is not a function");
     return v8::ThrowException(v8::Exception::TypeError(
           v8::String::New(message.c_str())));
@@ -92,14 +92,20 @@ public:
    * The returned module will execute in the provided context. This
    * constructor is intended for use by the main module.
    *
+   * If shared is true the module does not own the global object of
+   * context. The 'exports', 'require' and 'module' objects are not
+   * installed on it and must be passed to the module code by the caller.
+   *
    * \param id [in] The ID of the new module
    * \param file_name [in] The absolute path of the file containing the module
    * \param secure [in] Indicates if this should be a secure module
    * \param require [in] The object implementing the 'require' function
    * \param context [in] The context this module should execute in
+   * \param shared [in] Indicates if context is shared with other modules
    */
   Module(const char* id, const char* file_name, bool secure,
-      v8::Handle<v8::Object> require, v8::Handle<v8::Context> context);
+      v8::Handle<v8::Object> require, v8::Handle<v8::Context> context,
+      bool shared = false);
 
   /**
    * \brief Construct a module in a new V8 context
@@ -164,6 +170,24 @@ public:
     return module_;
   }
 
+  /**
+   * \brief Get the template for module global objects
+   *
+   * The template holds the built-in objects available to every module,
+   * i.e., the TypedArray constructors and (if not secure) 'print'. It is
+   * built once and used to create the context of each new module.
+   * Embedders may pass it to v8::Context::New() as well.
+   *
+   * The constructors are accessors that create the constructor function
+   * on first access and replace themselves with a plain property, so a
+   * context only pays for the constructors it uses.
+   *
+   * \param secure [in] Indicates if the template is for secure modules
+   *
+   * \return The global object template.
+   */
+  static v8::Handle<v8::ObjectTemplate> GetGlobalTemplate(bool secure = false);
+
 public: // Module helper functions
   /**
    * \brief Require a module from C++
@@ -191,6 +215,10 @@ public: // Module helper functions
   static v8::Handle<v8::Value> CallMethod(v8::Handle<v8::Object> object,
       const char* method, int argc, v8::Handle<v8::Value> argv[]);
 
+  /// \brief Call a method by a name that has already been created
+  static v8::Handle<v8::Value> CallMethod(v8::Handle<v8::Object> object,
+      v8::Handle<v8::String> method, int argc, v8::Handle<v8::Value> argv[]);
+
 public: // Sub-classes
   class MOKA_EXPORT Exception {
   public:
@@ -257,6 +285,25 @@ protected:
     return exports_;
   }
 
+  /**
+   * \brief Get the V8 'require' object for this module
+   *
+   * \return The V8 'require' object.
+   */
+  const v8::Handle<v8::Object> GetRequire() const {
+    return require_;
+  }
+
+  /**
+   * \brief Check if this module shares its context with other modules
+   *
+   * \return This function returns true if the module context is shared,
+   *         false otherwise.
+   */
+  bool IsShared() const {
+    return shared_;
+  }
+
 private: // non-copyable
   Module(Module const& that);
 
@@ -265,6 +312,12 @@ private: // non-copyable
 private: // private methods
   static v8::Handle<v8::Value> Print(const v8::Arguments& args);
 
+  static v8::Handle<v8::Value> GetLazyFunction(v8::Local<v8::String> name,
+      const v8::AccessorInfo& info);
+
+  static void SetLazyFunction(v8::Local<v8::String> name,
+      v8::Local<v8::Value> value, const v8::AccessorInfo& info);
+
 private: // private data
   std::string id_;
   std::string file_name_;
@@ -272,6 +325,7 @@ private: // private data
   bool secure_;
   bool initialized_;
   bool context_owner_;
+  bool shared_;
   v8::Persistent<v8::Context> context_;
   v8::Persistent<v8::Object> require_;
   v8::Persistent<v8::Object> exports_;
@@ -0,0 +1,245 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Packs a directory of script modules into a bundle
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ftw.h>
+#include <map>
+#include "moka/bundle.h"
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+/// \brief Module sources keyed by module ID
+typedef std::map<std::string, std::string> SourceMap;
+
+/// \brief The directory being packed
+static std::string root;
+
+/// \brief Modules found by Collect()
+static SourceMap sources;
+
+/**
+ * \brief Read a script module found while walking the directory
+ *
+ * The module ID is the path of the file relative to the directory being
+ * packed, without the '.js' suffix.
+ */
+static int Collect(const char* file_name, const struct stat* buf, int flag,
+    struct FTW* ftw) {
+  if (FTW_F != flag) {
+    return 0;
+  }
+  size_t length = strlen(file_name);
+  if (length < 3 || strcmp(file_name + length - 3, ".js")) {
+    return 0;
+  }
+  FILE* file = fopen(file_name, "rb");
+  if (!file) {
+    fprintf(stderr, "error: %s: %s\n", file_name, strerror(errno));
+    return 1;
+  }
+  std::string source(buf->st_size, '\0');
+  if (buf->st_size && 1 != fread(&source[0], buf->st_size, 1, file)) {
+    fprintf(stderr, "error: %s: short read\n", file_name);
+    fclose(file);
+    return 1;
+  }
+  fclose(file);
+  std::string id(file_name + root.length() + 1, length - root.length() - 4);
+  sources[id] = source;
+  return 0;
+}
+
+/**
+ * \brief Pad a file with zeros to an eight byte boundary
+ *
+ * \return The new file offset.
+ */
+static uint64_t Align(FILE* file, uint64_t offset) {
+  static const char zeros[8] = { 0 };
+  uint64_t padding = (8 - (offset & 7)) & 7;
+  if (padding) {
+    fwrite(zeros, padding, 1, file);
+  }
+  return offset + padding;
+}
+
+static bool IsAscii(const std::string& source) {
+  for (std::string::size_type index = 0; index < source.length(); ++index) {
+    if (source[index] & 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool precompile = false;
+  int option;
+  while (-1 != (option = getopt(argc, argv, "c"))) {
+    switch (option) {
+    case 'c':
+      precompile = true;
+      break;
+    default:
+      fprintf(stderr, "error: %s [-c] <bundle> <directory>\n", argv[0]);
+      return 1;
+    }
+  }
+  if (argc - optind != 2) {
+    fprintf(stderr, "error: %s [-c] <bundle> <directory>\n", argv[0]);
+    return 1;
+  }
+  const char* bundle_name = argv[optind];
+  char resolved_path[PATH_MAX];
+  if (!realpath(argv[optind + 1], resolved_path)) {
+    fprintf(stderr, "error: %s: %s\n", argv[optind + 1], strerror(errno));
+    return 1;
+  }
+  root.assign(resolved_path);
+  // Read every script module below the directory
+  if (nftw(root.c_str(), Collect, 16, FTW_PHYS)) {
+    return 1;
+  }
+  // Pre-compile the modules, V8 is only used here and is disposed before
+  // anything is written
+  std::vector<std::string> data(sources.size());
+  if (precompile) {
+    {
+      v8::HandleScope handle_scope;
+      size_t index = 0;
+      for (SourceMap::iterator iter = sources.begin();
+          iter != sources.end(); ++iter, ++index) {
+        v8::ScriptData* script_data = v8::ScriptData::PreCompile(
+            iter->second.data(), iter->second.length());
+        if (script_data && !script_data->HasError()) {
+          data[index].assign(script_data->Data(), script_data->Length());
+        }
+        delete script_data;
+      }
+    }
+    v8::V8::Dispose();
+  }
+  // Lay out the string table and the data section
+  moka::internal::BundleHeader header;
+  memcpy(header.magic, moka::internal::kBundleMagic,
+      sizeof(header.magic));
+  header.version = moka::internal::kBundleVersion;
+  header.count = sources.size();
+  header.strings_offset = sizeof(header)
+    + sources.size() * sizeof(moka::internal::BundleEntry);
+  header.strings_length = 0;
+  std::vector<moka::internal::BundleEntry> entries(sources.size());
+  size_t index = 0;
+  for (SourceMap::iterator iter = sources.begin(); iter != sources.end();
+      ++iter, ++index) {
+    entries[index].id_offset = header.strings_length;
+    entries[index].id_length = iter->first.length();
+    header.strings_length += iter->first.length();
+  }
+  uint64_t offset = header.strings_offset + header.strings_length;
+  index = 0;
+  for (SourceMap::iterator iter = sources.begin(); iter != sources.end();
+      ++iter, ++index) {
+    moka::internal::BundleEntry& entry = entries[index];
+    offset += (8 - (offset & 7)) & 7;
+    entry.source_offset = offset;
+    entry.source_length = iter->second.length();
+    offset += entry.source_length;
+    if (data[index].empty()) {
+      entry.cache_offset = 0;
+      entry.cache_length = 0;
+    } else {
+      offset += (8 - (offset & 7)) & 7;
+      entry.cache_offset = offset;
+      entry.cache_length = data[index].length();
+      offset += entry.cache_length;
+    }
+    entry.hash = moka::internal::Bundle::Hash(iter->second.data(),
+        iter->second.length());
+    entry.flags = IsAscii(iter->second) ? moka::internal::kBundleAscii : 0;
+  }
+  // Write to a temporary file and rename it into place
+  std::string temp_name(bundle_name);
+  temp_name.append(".XXXXXX");
+  int fd = mkstemp(&temp_name[0]);
+  if (-1 == fd) {
+    fprintf(stderr, "error: %s: %s\n", temp_name.c_str(), strerror(errno));
+    return 1;
+  }
+  FILE* file = NULL;
+  if (fchmod(fd, 0644) || !(file = fdopen(fd, "wb"))) {
+    fprintf(stderr, "error: %s: %s\n", temp_name.c_str(), strerror(errno));
+    close(fd);
+    unlink(temp_name.c_str());
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, file);
+  if (!entries.empty()) {
+    fwrite(&entries[0], sizeof(entries[0]), entries.size(), file);
+  }
+  for (SourceMap::iterator iter = sources.begin(); iter != sources.end();
+      ++iter) {
+    fwrite(iter->first.data(), iter->first.length(), 1, file);
+  }
+  offset = header.strings_offset + header.strings_length;
+  index = 0;
+  for (SourceMap::iterator iter = sources.begin(); iter != sources.end();
+      ++iter, ++index) {
+    offset = Align(file, offset);
+    fwrite(iter->second.data(), iter->second.length(), 1, file);
+    offset += iter->second.length();
+    if (!data[index].empty()) {
+      offset = Align(file, offset);
+      fwrite(data[index].data(), data[index].length(), 1, file);
+      offset += data[index].length();
+    }
+  }
+  bool status = !ferror(file);
+  if (fclose(file)) {
+    status = false;
+  }
+  if (!status || rename(temp_name.c_str(), bundle_name)) {
+    fprintf(stderr, "error: %s: %s\n", bundle_name, strerror(errno));
+    unlink(temp_name.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+// vim: tabstop=2:sw=2:expandtab
@@ -29,13 +29,25 @@
 #include "config.h"
 #endif
 
-#include <cerrno>
 #include <cstdio>
-#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
 #include "moka/moka.h"
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <unistd.h>
+#include <sstream>
+#include <string>
+
+/**
+ * \brief Get the current time
+ *
+ * \return Microseconds from an arbitrary, fixed point in time.
+ */
+static unsigned long long Now() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<unsigned long long>(now.tv_sec) * 1000000
+    + now.tv_nsec / 1000;
+}
 
 void Report(v8::TryCatch& try_catch) {
   v8::HandleScope handle_scope;
@@ -49,95 +61,154 @@ void Report(v8::TryCatch& try_catch) {
       message->GetLineNumber(), *v8::String::Utf8Value(try_catch.Exception()));
 }
 
+/**
+ * \brief Add the modules listed in MOKAPRELOAD to the module loader
+ *
+ * MOKAPRELOAD is a colon separated list of module IDs. An entry starting
+ * with '@' names a manifest file listing one module ID per line, empty
+ * lines and lines starting with '#' are ignored.
+ *
+ * \param loader [in] The module loader
+ * \param preload [in] The value of MOKAPRELOAD
+ */
+static void AddPreloads(moka::ModuleLoader& loader, const char* preload) {
+  std::string entry;
+  std::stringstream entries(preload);
+  while (std::getline(entries, entry, ':')) {
+    if (entry.empty()) {
+      continue;
+    }
+    if ('@' != entry[0]) {
+      loader.AddPreload(entry.c_str());
+      continue;
+    }
+    std::ifstream manifest(entry.c_str() + 1);
+    if (!manifest) {
+      fprintf(stderr, "warning: %s: cannot read preload manifest\n",
+          entry.c_str() + 1);
+      continue;
+    }
+    std::string id;
+    while (std::getline(manifest, id)) {
+      if (!id.empty() && '#' != id[0]) {
+        loader.AddPreload(id.c_str());
+      }
+    }
+  }
+}
+
 int main(int argc, char *argv[]) {
   if (argc < 2) {
     fprintf(stderr, "error: %s <script>\n", argv[0]);
     return 1;
   }
+  unsigned long long start = Now();
   // Create a stack allocated handle scope
   v8::HandleScope handle_scope;
   // Create a new context
   v8::Persistent<v8::Context> context = v8::Context::New();
   // Enter the created context
   v8::Context::Scope scope(context);
+  unsigned long long context_created = Now();
   // Initialize module loader
   moka::ModuleLoader loader;
-  if (!loader.Initialize(argv[1], &argc, &argv)) {
-    fprintf(stderr, "error: module loader: %s\n", loader.GetError());
-    context.Dispose();
-    v8::V8::Dispose();
-    return 1;
+  // Cache entries are keyed on the modification time and size of scripts,
+  // scripts are also mapped into memory and must be replaced by rename,
+  // not rewritten in place (see moka/mapped-source.h)
+  const char* cache_directory = getenv("MOKACACHE");
+  if (cache_directory) {
+    loader.SetCacheDirectory(cache_directory);
   }
-  // Read file into a v8 string
-  FILE* file = fopen(argv[1], "rb");
-  if (!file) {
-    fprintf(stderr, "error: %s\n", strerror(errno));
-    context.Dispose();
-    v8::V8::Dispose();
-    return 1;
+  const char* trace_file = getenv("MOKATRACE");
+  if (trace_file) {
+    loader.SetTraceFile(trace_file);
   }
-  struct stat buf;
-  if (fstat(fileno(file), &buf)) {
-    fprintf(stderr, "error: %s\n", strerror(errno));
-    context.Dispose();
-    v8::V8::Dispose();
-    fclose(file);
-    return 1;
+  const char* bundle = getenv("MOKABUNDLE");
+  if (bundle) {
+    loader.SetBundle(bundle);
   }
-  if (!S_ISREG(buf.st_mode)) {
-    fprintf(stderr, "error: '%s' is not a regular file\n", argv[1]);
-    context.Dispose();
-    v8::V8::Dispose();
-    fclose(file);
-    return 1;
+  if (getenv("MOKASHARED")) {
+    loader.SetSharedContext(true);
   }
-  char* characters = new char[buf.st_size + 1];
-  if (!characters) {
-    fprintf(stderr, "error: %s\n", strerror(errno));
-    context.Dispose();
-    v8::V8::Dispose();
-    fclose(file);
-    return 1;
+  const char* directory_cache_ttl = getenv("MOKADIRCACHE");
+  if (directory_cache_ttl) {
+    loader.SetDirectoryCacheTtl(atoi(directory_cache_ttl));
   }
-  size_t size = fread(characters, 1, buf.st_size, file);
-  if (static_cast<off_t>(size) < buf.st_size) {
-    if (ferror(file)) {
-      fprintf(stderr, "error: %s\n", strerror(errno));
-      context.Dispose();
-      v8::V8::Dispose();
-      delete[] characters;
-      fclose(file);
-      return 1;
-    }
-    clearerr(file);
+  const char* time_limit = getenv("MOKATIMELIMIT");
+  if (time_limit) {
+    loader.SetTimeLimit(atoi(time_limit));
   }
-  fclose(file);
-  v8::Handle<v8::String> source = v8::String::New(characters, size);
-  delete[] characters;
-  if (source.IsEmpty()) {
-    fprintf(stderr, "error: failed to read %s\n", argv[1]);
-    context.Dispose();
-    v8::V8::Dispose();
-    return 1;
+  const char* cpu_limit = getenv("MOKACPULIMIT");
+  if (cpu_limit) {
+    loader.SetCpuLimit(atoi(cpu_limit));
   }
-  // Compile string
-  v8::TryCatch try_catch;
-  v8::Handle<v8::Script> script = v8::Script::Compile(source,
-      v8::String::New(argv[1]));
-  if (script.IsEmpty()) {
-    Report(try_catch);
+  const char* heap_limit = getenv("MOKAHEAPLIMIT");
+  if (heap_limit) {
+    loader.SetHeapLimit(strtoul(heap_limit, NULL, 10));
+  }
+  const char* max_modules = getenv("MOKAMAXMODULES");
+  if (max_modules) {
+    loader.SetMaxModules(atoi(max_modules));
+  }
+  if (getenv("MOKAPREFETCH")) {
+    loader.SetPrefetch(true);
+  }
+  const char* preload = getenv("MOKAPRELOAD");
+  if (preload) {
+    AddPreloads(loader, preload);
+  }
+  if (getenv("MOKAPRELOADNOW")) {
+    loader.SetPreloadNow(true);
+  }
+  const char* pool = getenv("MOKAPOOL");
+  if (pool && !moka::Memory::SetBufferPool(atoi(pool))) {
+    fprintf(stderr, "warning: MOKAPOOL: ArrayBuffers are already allocated,"
+        " ignored\n");
+  }
+  if (getenv("MOKAHUGEPAGES")) {
+    moka::Memory::SetHugePages(true);
+  }
+  if (!loader.Initialize(argv[1], &argc, &argv)) {
+    fprintf(stderr, "error: module loader: %s\n", loader.GetError());
     context.Dispose();
     v8::V8::Dispose();
     return 1;
   }
-  // Execute string
-  v8::Handle<v8::Value> result = script->Run();
+  unsigned long long initialized = Now();
+  // Compile and execute the main script
+  v8::TryCatch try_catch;
+  v8::Handle<v8::Value> result = loader.Run();
   if (result.IsEmpty()) {
-    Report(try_catch);
+    if (loader.GetTerminationReason()) {
+      fprintf(stderr, "error: terminated: %s\n",
+          loader.GetTerminationReason());
+    } else {
+      Report(try_catch);
+    }
     context.Dispose();
     v8::V8::Dispose();
     return 1;
   }
+  if (getenv("MOKASTATS")) {
+    fprintf(stderr, "startup: %llu us context, %llu us loader, %llu us run\n",
+        context_created - start, initialized - context_created,
+        Now() - initialized);
+    fprintf(stderr, "code cache: %u hits, %u misses\n",
+        loader.GetCacheHits(), loader.GetCacheMisses());
+    v8::HeapStatistics heap;
+    v8::V8::GetHeapStatistics(&heap);
+    fprintf(stderr, "heap: %lu bytes used, %lu bytes total\n",
+        static_cast<unsigned long>(heap.used_heap_size()),
+        static_cast<unsigned long>(heap.total_heap_size()));
+    moka::Memory::Statistics memory;
+    moka::Memory::GetStatistics(&memory);
+    fprintf(stderr, "external: %lld bytes array buffers, %lld bytes views\n",
+        static_cast<long long>(memory.array_buffer_bytes),
+        static_cast<long long>(memory.view_bytes));
+    fprintf(stderr, "mapped array buffers: %lu bytes, %lu bytes resident\n",
+        static_cast<unsigned long>(memory.mapped_bytes),
+        static_cast<unsigned long>(memory.resident_bytes));
+  }
   // Clean up
   context.Dispose();
   v8::V8::Dispose();
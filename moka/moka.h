@@ -41,12 +41,18 @@
 #ifndef MOKA_H
 #define MOKA_H
 
+// Include the memory statistics API
+#include <moka/memory.h>
+
 // Include the module API
 #include <moka/module.h>
 
 // Include the module loader API
 #include <moka/module-loader.h>
 
+// Include the runtime pool API
+#include <moka/runtime.h>
+
 #endif // MOKA_H
 
 // vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,317 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/prefetcher.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include "moka/code-cache.h"
+#include "moka/mapped-source.h"
+#include "moka/prefetcher.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace moka {
+
+namespace internal {
+
+PrefetchedSource::~PrefetchedSource() {
+  delete source_;
+}
+
+v8::Local<v8::String> PrefetchedSource::NewString() {
+  if (!source_) {
+    return v8::String::Empty();
+  }
+  MappedSource* source = source_;
+  source_ = NULL;
+  return MappedSource::NewString(source);
+}
+
+static inline bool IsSpace(char c) {
+  return isspace(static_cast<unsigned char>(c));
+}
+
+/**
+ * \brief Find literal 'require' calls in a script
+ *
+ * The search is purely lexical, calls inside comments or strings are
+ * also found. This is harmless, the modules are just read needlessly.
+ *
+ * \param data [in] The script source
+ * \param length [in] The length of data in bytes
+ * \param ids [out] The module IDs passed to 'require'
+ */
+static void FindRequires(const char* data, size_t length,
+    std::vector<std::string>* ids) {
+  static const char kRequire[] = "require";
+  static const size_t kLength = sizeof(kRequire) - 1;
+  for (size_t index = 0; index + kLength < length; ++index) {
+    if ('r' != data[index]
+        || ::memcmp(data + index, kRequire, kLength)) {
+      continue;
+    }
+    // Skip member expressions and longer identifiers
+    if (index > 0) {
+      unsigned char previous = data[index - 1];
+      if (isalnum(previous) || '_' == previous || '$' == previous
+          || '.' == previous) {
+        continue;
+      }
+    }
+    size_t position = index + kLength;
+    while (position < length && IsSpace(data[position])) {
+      ++position;
+    }
+    if (position >= length || '(' != data[position++]) {
+      continue;
+    }
+    while (position < length && IsSpace(data[position])) {
+      ++position;
+    }
+    if (position >= length
+        || ('\'' != data[position] && '"' != data[position])) {
+      continue;
+    }
+    char quote = data[position++];
+    size_t begin = position;
+    while (position < length && quote != data[position]
+        && '\\' != data[position] && '\n' != data[position]) {
+      ++position;
+    }
+    if (position >= length || quote != data[position]
+        || begin == position) {
+      continue;
+    }
+    size_t end = position++;
+    while (position < length && IsSpace(data[position])) {
+      ++position;
+    }
+    if (position >= length || ')' != data[position]) {
+      continue;
+    }
+    ids->push_back(std::string(data + begin, end - begin));
+    index = position;
+  }
+}
+
+Prefetcher::Prefetcher(CodeCache* code_cache, BundlePointer bundle,
+    bool wrapped)
+  : code_cache_(code_cache)
+  , bundle_(bundle)
+  , wrapped_(wrapped)
+  , started_(false)
+  , stopping_(false) {
+  ::pthread_mutex_init(&mutex_, NULL);
+  ::pthread_cond_init(&cond_, NULL);
+}
+
+Prefetcher::~Prefetcher() {
+  if (started_) {
+    ::pthread_mutex_lock(&mutex_);
+    stopping_ = true;
+    ::pthread_cond_broadcast(&cond_);
+    ::pthread_mutex_unlock(&mutex_);
+    ::pthread_join(thread_, NULL);
+  }
+  for (SourceMap::iterator iter = sources_.begin(); iter != sources_.end();
+      ++iter) {
+    delete (*iter).second;
+  }
+  ::pthread_cond_destroy(&cond_);
+  ::pthread_mutex_destroy(&mutex_);
+}
+
+bool Prefetcher::Start() {
+  if (started_) {
+    return true;
+  }
+  if (::pthread_create(&thread_, NULL, Run, this)) {
+    return false;
+  }
+  started_ = true;
+  return true;
+}
+
+void Prefetcher::SetPaths(const std::vector<std::string>& paths) {
+  ::pthread_mutex_lock(&mutex_);
+  paths_ = paths;
+  ::pthread_mutex_unlock(&mutex_);
+}
+
+void Prefetcher::Scan(const char* file_name) {
+  ::pthread_mutex_lock(&mutex_);
+  if (scanned_.insert(file_name).second) {
+    queue_.push_back(file_name);
+    ::pthread_cond_signal(&cond_);
+  }
+  ::pthread_mutex_unlock(&mutex_);
+}
+
+ScriptSource* Prefetcher::Take(const char* file_name) {
+  ScriptSource* source = NULL;
+  ::pthread_mutex_lock(&mutex_);
+  while (current_ == file_name) {
+    ::pthread_cond_wait(&cond_, &mutex_);
+  }
+  SourceMap::iterator iter = sources_.find(file_name);
+  if (sources_.end() != iter) {
+    source = (*iter).second;
+    sources_.erase(iter);
+  }
+  claimed_.insert(file_name);
+  ::pthread_mutex_unlock(&mutex_);
+  return source;
+}
+
+void* Prefetcher::Run(void* data) {
+  Prefetcher* prefetcher = static_cast<Prefetcher*>(data);
+  ::pthread_mutex_lock(&prefetcher->mutex_);
+  for (;;) {
+    while (!prefetcher->stopping_ && prefetcher->queue_.empty()) {
+      ::pthread_cond_wait(&prefetcher->cond_, &prefetcher->mutex_);
+    }
+    if (prefetcher->stopping_) {
+      break;
+    }
+    std::string file_name(prefetcher->queue_.front());
+    prefetcher->queue_.pop_front();
+    prefetcher->current_ = file_name;
+    ::pthread_mutex_unlock(&prefetcher->mutex_);
+    prefetcher->Process(file_name);
+    ::pthread_mutex_lock(&prefetcher->mutex_);
+    prefetcher->current_.clear();
+    // Wake up Take()
+    ::pthread_cond_broadcast(&prefetcher->cond_);
+  }
+  ::pthread_mutex_unlock(&prefetcher->mutex_);
+  return NULL;
+}
+
+void Prefetcher::Process(const std::string& file_name) {
+  // Map the script
+  int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (-1 == fd) {
+    return;
+  }
+  struct stat buf;
+  if (::fstat(fd, &buf) || !S_ISREG(buf.st_mode)) {
+    ::close(fd);
+    return;
+  }
+  MappedSource* mapped_source = NULL;
+  if (buf.st_size) {
+    mapped_source = MappedSource::New(fd, buf.st_size);
+    if (!mapped_source) {
+      ::close(fd);
+      return;
+    }
+  }
+  ::close(fd);
+  // Scanning the script faults in all of its pages
+  std::vector<std::string> ids;
+  if (mapped_source) {
+    FindRequires(mapped_source->data(), mapped_source->length(), &ids);
+  }
+  if (code_cache_) {
+    code_cache_->Prefetch(file_name.c_str(), buf.st_mtime, buf.st_size,
+        wrapped_);
+  }
+  // Resolve dependencies
+  std::string directory(file_name, 0, file_name.rfind('/'));
+  std::vector<std::string> file_names;
+  for (std::vector<std::string>::iterator iter = ids.begin();
+      iter != ids.end(); ++iter) {
+    std::string dependency;
+    if (Resolve(*iter, directory, &dependency)) {
+      file_names.push_back(dependency);
+    }
+  }
+  // Publish the script unless it has been loaded without waiting for it
+  ::pthread_mutex_lock(&mutex_);
+  if (!claimed_.count(file_name)) {
+    PrefetchedSource* source =
+      new PrefetchedSource(mapped_source, buf.st_size, buf.st_mtime);
+    if (source) {
+      sources_[file_name] = source;
+      mapped_source = NULL;
+    }
+  }
+  for (std::vector<std::string>::iterator iter = file_names.begin();
+      iter != file_names.end(); ++iter) {
+    if (scanned_.insert(*iter).second) {
+      queue_.push_back(*iter);
+    }
+  }
+  ::pthread_mutex_unlock(&mutex_);
+  delete mapped_source;
+}
+
+bool Prefetcher::Resolve(const std::string& id, const std::string& directory,
+    std::string* file_name) {
+  std::vector<std::string> directories;
+  if (0 == id.compare(0, 2, "./") || 0 == id.compare(0, 3, "../")) {
+    directories.push_back(directory);
+  } else {
+    if (bundle_.get() && bundle_->Find(id)) {
+      // Served from the bundle
+      return false;
+    }
+    ::pthread_mutex_lock(&mutex_);
+    directories = paths_;
+    ::pthread_mutex_unlock(&mutex_);
+  }
+  char resolved_path[PATH_MAX];
+  for (std::vector<std::string>::iterator iter = directories.begin();
+      iter != directories.end(); ++iter) {
+    std::string candidate(*iter);
+    candidate.append("/");
+    candidate.append(id);
+    candidate.append(".js");
+    struct stat buf;
+    if (realpath(candidate.c_str(), resolved_path)
+        && !::stat(resolved_path, &buf) && S_ISREG(buf.st_mode)) {
+      file_name->assign(resolved_path);
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
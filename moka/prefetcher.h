@@ -0,0 +1,198 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Reads the dependencies of script modules on a background thread
+ */
+
+#ifndef MOKA_PREFETCHER_H
+#define MOKA_PREFETCHER_H
+
+#include <ctime>
+#include <deque>
+#include <map>
+#include "moka/bundle.h"
+#include "moka/script-source.h"
+#include <pthread.h>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace moka {
+
+namespace internal {
+
+class CodeCache;
+class MappedSource;
+class PrefetchedSource;
+class Prefetcher;
+
+} // namespace internal
+
+} // namespace moka
+
+/// \brief A script mapped by the prefetcher
+class moka::internal::PrefetchedSource: public moka::internal::ScriptSource {
+public:
+  /**
+   * \brief Construct a source from a mapped file
+   *
+   * \param source [in] The mapped file (this object will own source), may
+   *                    be NULL if the file is empty
+   * \param size [in] The size of the file in bytes
+   * \param mtime [in] The modification time of the file
+   */
+  PrefetchedSource(MappedSource* source, size_t size, time_t mtime)
+    : source_(source)
+    , size_(size)
+    , mtime_(mtime) {}
+
+  /// \brief Unmaps the file if it has not been read
+  virtual ~PrefetchedSource();
+
+  virtual v8::Local<v8::String> NewString();
+
+  virtual time_t GetMtime() const {
+    return mtime_;
+  }
+
+  virtual size_t GetSize() const {
+    return size_;
+  }
+
+private: // non-copyable
+  PrefetchedSource(PrefetchedSource const& that);
+
+  void operator=(PrefetchedSource const& that);
+
+private: // private data
+  MappedSource* source_;
+  size_t size_;
+  time_t mtime_;
+};
+
+/**
+ * \brief The module prefetcher
+ *
+ * Script modules handed to Scan() are read on a background thread and
+ * searched for literal 'require("...")' calls. Each module ID found is
+ * resolved like ModuleLoader::Require() would resolve it, the script is
+ * mapped and its pages are faulted in, the matching code cache entry is
+ * read, and the script is scanned in turn. The module factory claims
+ * the mapping with Take() when the module is actually required.
+ *
+ * The background thread never calls into V8.
+ */
+class moka::internal::Prefetcher {
+public:
+  /**
+   * \brief Construct a prefetcher
+   *
+   * \param code_cache [in] The code cache entries are prefetched into,
+   *                        may be NULL
+   * \param bundle [in] Module IDs found in this bundle are not prefetched
+   * \param wrapped [in] Indicates if script modules are wrapped in a module
+   *                     function (shared context mode)
+   */
+  Prefetcher(CodeCache* code_cache, BundlePointer bundle, bool wrapped);
+
+  /// \brief Stops the background thread and unmaps unclaimed scripts
+  ~Prefetcher();
+
+  /**
+   * \brief Start the background thread
+   *
+   * \return This function returns true if the thread was started, false
+   *         otherwise.
+   */
+  bool Start();
+
+  /**
+   * \brief Set the directories top-level module IDs are resolved in
+   *
+   * \param paths [in] A snapshot of 'require.paths'
+   */
+  void SetPaths(const std::vector<std::string>& paths);
+
+  /**
+   * \brief Scan a script for dependencies
+   *
+   * Scripts that have been scanned before are ignored.
+   *
+   * \param file_name [in] The absolute path of a script module
+   */
+  void Scan(const char* file_name);
+
+  /**
+   * \brief Claim a prefetched script
+   *
+   * If the background thread is reading file_name this function waits
+   * for it to finish. Once a script has been claimed the background
+   * thread will not map it again.
+   *
+   * \param file_name [in] The absolute path of a script module
+   *
+   * \return A source for file_name or NULL if the script has not been
+   *         prefetched.
+   */
+  ScriptSource* Take(const char* file_name);
+
+private: // non-copyable
+  Prefetcher(Prefetcher const& that);
+
+  void operator=(Prefetcher const& that);
+
+private: // private methods
+  typedef std::map<std::string, ScriptSource*> SourceMap;
+
+  static void* Run(void* data);
+
+  void Process(const std::string& file_name);
+
+  bool Resolve(const std::string& id, const std::string& directory,
+      std::string* file_name);
+
+private: // private data
+  CodeCache* code_cache_;
+  BundlePointer bundle_;
+  bool wrapped_;
+  bool started_;
+  bool stopping_;
+  pthread_t thread_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  std::vector<std::string> paths_;
+  std::deque<std::string> queue_;
+  std::set<std::string> scanned_;
+  std::set<std::string> claimed_;
+  std::string current_;
+  SourceMap sources_;
+};
+
+#endif // MOKA_PREFETCHER_H
+
+// vim: tabstop=2:sw=2:expandtab
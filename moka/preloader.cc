@@ -0,0 +1,147 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/preloader.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <climits>
+#include <cstdlib>
+#include <dlfcn.h>
+#include "moka/preloader.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace moka {
+
+namespace internal {
+
+Preloader::Preloader(const std::vector<std::string>& ids,
+    const std::vector<std::string>& paths, int flags)
+  : ids_(ids)
+  , paths_(paths)
+  , flags_(flags)
+  , started_(false) {
+  ::pthread_mutex_init(&mutex_, NULL);
+  ::pthread_cond_init(&cond_, NULL);
+}
+
+Preloader::~Preloader() {
+  if (started_) {
+    ::pthread_join(thread_, NULL);
+  }
+  for (HandleMap::iterator iter = handles_.begin(); iter != handles_.end();
+      ++iter) {
+    ::dlclose((*iter).second);
+  }
+  ::pthread_cond_destroy(&cond_);
+  ::pthread_mutex_destroy(&mutex_);
+}
+
+bool Preloader::Start() {
+  if (started_) {
+    return true;
+  }
+  for (std::vector<std::string>::iterator iter = ids_.begin();
+      iter != ids_.end(); ++iter) {
+    Resolve(*iter);
+  }
+  if (::pthread_create(&thread_, NULL, Run, this)) {
+    pending_.clear();
+    return false;
+  }
+  started_ = true;
+  return true;
+}
+
+void* Preloader::Take(const char* file_name) {
+  void* handle = NULL;
+  ::pthread_mutex_lock(&mutex_);
+  for (;;) {
+    HandleMap::iterator iter = handles_.find(file_name);
+    if (handles_.end() != iter) {
+      handle = (*iter).second;
+      handles_.erase(iter);
+      break;
+    }
+    if (pending_.end() == pending_.find(file_name)) {
+      // Not preloaded or failed to open
+      break;
+    }
+    ::pthread_cond_wait(&cond_, &mutex_);
+  }
+  ::pthread_mutex_unlock(&mutex_);
+  return handle;
+}
+
+void* Preloader::Run(void* data) {
+  Preloader* preloader = static_cast<Preloader*>(data);
+  for (std::vector<std::string>::iterator iter = preloader->files_.begin();
+      iter != preloader->files_.end(); ++iter) {
+    preloader->Open(*iter);
+  }
+  return NULL;
+}
+
+void Preloader::Resolve(const std::string& id) {
+  char resolved_path[PATH_MAX];
+  for (std::vector<std::string>::iterator iter = paths_.begin();
+      iter != paths_.end(); ++iter) {
+    std::string file_name(*iter);
+    file_name.append("/");
+    file_name.append(id);
+    file_name.append(".so");
+    struct stat buf;
+    if (!realpath(file_name.c_str(), resolved_path)
+        || ::stat(resolved_path, &buf) || !S_ISREG(buf.st_mode)) {
+      continue;
+    }
+    if (pending_.insert(resolved_path).second) {
+      files_.push_back(resolved_path);
+    }
+    return;
+  }
+}
+
+void Preloader::Open(const std::string& file_name) {
+  void* handle = ::dlopen(file_name.c_str(), flags_);
+  ::pthread_mutex_lock(&mutex_);
+  pending_.erase(file_name);
+  if (handle) {
+    handles_[file_name] = handle;
+  }
+  ::pthread_cond_broadcast(&cond_);
+  ::pthread_mutex_unlock(&mutex_);
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
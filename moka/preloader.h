@@ -0,0 +1,133 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Opens shared object modules on a background thread
+ */
+
+#ifndef MOKA_PRELOADER_H
+#define MOKA_PRELOADER_H
+
+#include <map>
+#include <pthread.h>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace moka {
+
+namespace internal {
+
+class Preloader;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief The shared object module preloader
+ *
+ * Each module ID handed to the constructor is resolved to 'id.so' in the
+ * first search directory containing it when the preloader is started.
+ * The resolved files are opened with dlopen() on a background thread, so
+ * relocations and page faults happen while the main script is compiled.
+ * The module factory adopts the handles with Take() when the modules are
+ * required. Handles that are never adopted are closed when the preloader
+ * is destroyed.
+ *
+ * Static constructors of preloaded shared objects run on the background
+ * thread and must not call into V8.
+ */
+class moka::internal::Preloader {
+public:
+  /**
+   * \brief Construct a preloader
+   *
+   * \param ids [in] Top-level IDs of shared object modules
+   * \param paths [in] A snapshot of 'require.paths'
+   * \param flags [in] The dlopen() flags, e.g., RTLD_LAZY or RTLD_NOW
+   */
+  Preloader(const std::vector<std::string>& ids,
+      const std::vector<std::string>& paths, int flags);
+
+  /// \brief Waits for the background thread and closes unclaimed handles
+  ~Preloader();
+
+  /**
+   * \brief Resolve the module IDs and start the background thread
+   *
+   * \return This function returns true if the thread was started, false
+   *         otherwise.
+   */
+  bool Start();
+
+  /**
+   * \brief Claim a preloaded shared object
+   *
+   * If the shared object is about to be opened by the background thread
+   * this function waits for it. Files that are not being preloaded are
+   * never waited for.
+   *
+   * \param file_name [in] The absolute path of a shared object module
+   *
+   * \return The dlopen() handle of file_name (the caller takes ownership)
+   *         or NULL if the shared object has not been preloaded.
+   */
+  void* Take(const char* file_name);
+
+private: // non-copyable
+  Preloader(Preloader const& that);
+
+  void operator=(Preloader const& that);
+
+private: // private methods
+  typedef std::map<std::string, void*> HandleMap;
+
+  typedef std::set<std::string> FileSet;
+
+  static void* Run(void* data);
+
+  void Resolve(const std::string& id);
+
+  void Open(const std::string& file_name);
+
+private: // private data
+  std::vector<std::string> ids_;
+  std::vector<std::string> paths_;
+  int flags_;
+  std::vector<std::string> files_;
+  bool started_;
+  pthread_t thread_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  HandleMap handles_;
+  FileSet pending_;
+};
+
+#endif // MOKA_PRELOADER_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,289 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/runtime.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "moka/runtime.h"
+
+namespace moka {
+
+Runtime::Runtime(bool secure)
+  : error_("None")
+  , initialized_(false)
+  , loader_(secure) {}
+
+Runtime::~Runtime() {
+  define_property_.Dispose();
+  get_descriptor_.Dispose();
+  get_names_.Dispose();
+  baseline_.Dispose();
+  context_.Dispose();
+}
+
+/**
+ * \brief Get a function of the Object constructor
+ *
+ * \param name [in] The name of the function, e.g., "defineProperty"
+ *
+ * \return The function, or an empty handle if it is missing.
+ */
+static v8::Local<v8::Function> GetObjectFunction(const char* name) {
+  v8::Local<v8::Value> object = v8::Context::GetCurrent()->Global()->Get(
+      v8::String::NewSymbol("Object"));
+  if (object.IsEmpty() || !object->IsObject()) {
+    return v8::Local<v8::Function>();
+  }
+  v8::Local<v8::Value> function =
+    object->ToObject()->Get(v8::String::NewSymbol(name));
+  if (function.IsEmpty() || !function->IsFunction()) {
+    return v8::Local<v8::Function>();
+  }
+  return v8::Local<v8::Function>::Cast(function);
+}
+
+/**
+ * \brief Compare two values with the SameValue algorithm of ES5
+ *
+ * Unlike StrictEquals() NaN is the same as NaN, so a global NaN does not
+ * look modified.
+ */
+static bool SameValue(v8::Handle<v8::Value> a, v8::Handle<v8::Value> b) {
+  if (a->StrictEquals(b)) {
+    return true;
+  }
+  return a->IsNumber() && b->IsNumber()
+    && a->NumberValue() != a->NumberValue()
+    && b->NumberValue() != b->NumberValue();
+}
+
+// The fields of a property descriptor
+static const char* const kDescriptorFields[] = {
+  "value",
+  "get",
+  "set",
+  "writable",
+  "enumerable",
+  "configurable"
+};
+
+/// \brief Compare the fields of two property descriptors
+static bool SameDescriptor(v8::Handle<v8::Object> a,
+    v8::Handle<v8::Object> b) {
+  for (size_t index = 0; index < sizeof(kDescriptorFields)
+      / sizeof(kDescriptorFields[0]); ++index) {
+    v8::Local<v8::String> field =
+      v8::String::NewSymbol(kDescriptorFields[index]);
+    if (!SameValue(a->Get(field), b->Get(field))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Runtime::Initialize(const char* file_name) {
+  v8::HandleScope handle_scope;
+  if (initialized_) {
+    return true;
+  }
+  context_ = v8::Context::New();
+  if (context_.IsEmpty()) {
+    error_.assign("Failed to create a context");
+    return false;
+  }
+  v8::Context::Scope scope(context_);
+  // Keep the reflection functions before any script can replace them
+  v8::Local<v8::Function> get_names =
+    GetObjectFunction("getOwnPropertyNames");
+  v8::Local<v8::Function> get_descriptor =
+    GetObjectFunction("getOwnPropertyDescriptor");
+  v8::Local<v8::Function> define_property =
+    GetObjectFunction("defineProperty");
+  if (get_names.IsEmpty() || get_descriptor.IsEmpty()
+      || define_property.IsEmpty()) {
+    error_.assign("Failed to find the Object functions");
+    return false;
+  }
+  get_names_ = v8::Persistent<v8::Function>::New(get_names);
+  get_descriptor_ = v8::Persistent<v8::Function>::New(get_descriptor);
+  define_property_ = v8::Persistent<v8::Function>::New(define_property);
+  if (!loader_.Initialize(file_name)) {
+    error_.assign(loader_.GetError());
+    return false;
+  }
+  v8::TryCatch try_catch;
+  if (loader_.Run().IsEmpty()) {
+    error_.assign(*v8::String::Utf8Value(try_catch.Exception()));
+    return false;
+  }
+  // Record every own property of the global object with its attributes,
+  // this creates every lazy global once
+  v8::Local<v8::Object> global = context_->Global();
+  v8::Local<v8::Object> baseline = v8::Object::New();
+  v8::Handle<v8::Value> argv[2] = { global };
+  v8::Local<v8::Value> names = get_names_->Call(global, 1, argv);
+  if (names.IsEmpty() || !names->IsArray()) {
+    error_.assign("Failed to record the global object");
+    return false;
+  }
+  v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(names);
+  for (uint32_t index = 0; index < array->Length(); ++index) {
+    argv[1] = array->Get(index);
+    v8::Local<v8::Value> descriptor = get_descriptor_->Call(global, 2, argv);
+    if (!descriptor.IsEmpty() && descriptor->IsObject()) {
+      baseline->Set(argv[1], descriptor);
+    }
+  }
+  baseline_ = v8::Persistent<v8::Object>::New(baseline);
+  initialized_ = true;
+  return true;
+}
+
+v8::Handle<v8::Value> Runtime::Run(v8::Handle<v8::String> source,
+    v8::Handle<v8::Value> name) {
+  if (!initialized_) {
+    return v8::ThrowException(v8::String::New("Runtime is not initialized"));
+  }
+  v8::HandleScope handle_scope;
+  v8::Context::Scope scope(context_);
+  v8::TryCatch try_catch;
+  v8::Local<v8::Script> script = v8::Script::Compile(source, name);
+  if (script.IsEmpty()) {
+    return try_catch.ReThrow();
+  }
+  v8::Handle<v8::Value> result = loader_.Run(script);
+  if (result.IsEmpty()) {
+    return try_catch.ReThrow();
+  }
+  return handle_scope.Close(result);
+}
+
+void Runtime::Reset() {
+  if (!initialized_) {
+    return;
+  }
+  v8::HandleScope handle_scope;
+  v8::Context::Scope scope(context_);
+  v8::TryCatch try_catch;
+  v8::Local<v8::Object> global = context_->Global();
+  v8::Handle<v8::Value> argv[3] = { global };
+  // Delete new properties and restore redefined ones
+  v8::Local<v8::Value> names = get_names_->Call(global, 1, argv);
+  if (names.IsEmpty() || !names->IsArray()) {
+    return;
+  }
+  v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(names);
+  for (uint32_t index = 0; index < array->Length(); ++index) {
+    v8::Local<v8::String> name = array->Get(index)->ToString();
+    if (!baseline_->HasRealNamedProperty(name)) {
+      global->ForceDelete(name);
+      continue;
+    }
+    v8::Local<v8::Object> descriptor = baseline_->Get(name)->ToObject();
+    argv[1] = name;
+    v8::Local<v8::Value> current = get_descriptor_->Call(global, 2, argv);
+    if (!current.IsEmpty() && current->IsObject()
+        && SameDescriptor(descriptor, current->ToObject())) {
+      continue;
+    }
+    global->ForceDelete(name);
+    argv[2] = descriptor;
+    define_property_->Call(global, 3, argv);
+  }
+  // Restore deleted properties
+  array = baseline_->GetPropertyNames();
+  for (uint32_t index = 0; index < array->Length(); ++index) {
+    v8::Local<v8::String> name = array->Get(index)->ToString();
+    if (!global->HasRealNamedProperty(name)) {
+      argv[1] = name;
+      argv[2] = baseline_->Get(name);
+      define_property_->Call(global, 3, argv);
+    }
+  }
+}
+
+RuntimePool::RuntimePool(const char* file_name, bool secure)
+  : error_("None")
+  , file_name_(file_name)
+  , secure_(secure) {}
+
+RuntimePool::~RuntimePool() {
+  for (std::vector<Runtime*>::iterator iter = runtimes_.begin();
+      iter != runtimes_.end(); ++iter) {
+    delete *iter;
+  }
+}
+
+Runtime* RuntimePool::NewRuntime() {
+  Runtime* runtime = new Runtime(secure_);
+  if (!runtime) {
+    error_.assign("No memory");
+    return NULL;
+  }
+  if (!runtime->Initialize(file_name_.c_str())) {
+    error_.assign(runtime->GetError());
+    delete runtime;
+    return NULL;
+  }
+  runtimes_.push_back(runtime);
+  return runtime;
+}
+
+bool RuntimePool::Reserve(size_t count) {
+  while (available_.size() < count) {
+    Runtime* runtime = NewRuntime();
+    if (!runtime) {
+      return false;
+    }
+    available_.push_back(runtime);
+  }
+  return true;
+}
+
+Runtime* RuntimePool::Acquire() {
+  if (available_.empty()) {
+    return NewRuntime();
+  }
+  Runtime* runtime = available_.back();
+  available_.pop_back();
+  return runtime;
+}
+
+void RuntimePool::Release(Runtime* runtime) {
+  if (!runtime) {
+    return;
+  }
+  runtime->Reset();
+  available_.push_back(runtime);
+}
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
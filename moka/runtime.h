@@ -0,0 +1,230 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \file
+ * \brief Interface to pooled runtimes
+ */
+
+#ifndef MOKA_RUNTIME_H
+#define MOKA_RUNTIME_H
+
+#include <moka/macros.h>
+#include <moka/module-loader.h>
+#include <string>
+#include <v8.h>
+#include <vector>
+
+namespace moka {
+
+class Runtime;
+class RuntimePool;
+
+} // namespace moka
+
+/**
+ * \brief A pre-initialized execution environment
+ *
+ * A runtime owns a context and a module loader that has been initialized
+ * with a main script. The main script is run once and may require the
+ * modules requests will use. Scripts run with Run() share the global
+ * object and the module store of the runtime, Reset() restores the own
+ * properties of the global object, enumerable or not, to the state they
+ * had after the main script ran.
+ *
+ * Only the global object itself is restored. Changes made to objects it
+ * references, e.g., a method added to Array.prototype or a replaced
+ * Math.random, survive Reset() and are visible to later scripts, as is
+ * state kept in module exports since modules stay loaded. Scripts that
+ * must not observe each other need runtimes of their own.
+ */
+class MOKA_EXPORT moka::Runtime {
+public:
+  /**
+   * \brief Construct a runtime
+   *
+   * \param secure [in] Indicates if the module loader should be secure
+   */
+  Runtime(bool secure = false);
+
+  /// \brief Disposes the context
+  ~Runtime();
+
+  /**
+   * \brief Get the module loader
+   *
+   * The module loader may be configured before the runtime is
+   * initialized.
+   *
+   * \return The module loader of this runtime.
+   */
+  ModuleLoader& GetModuleLoader() {
+    return loader_;
+  }
+
+  /**
+   * \brief Get an error message after an initialization failure
+   *
+   * \return A detailed error message.
+   */
+  const char* GetError() const {
+    return error_.c_str();
+  }
+
+  /**
+   * \brief Create the context and run the main script
+   *
+   * \param file_name [in] The main script file name
+   *
+   * \return This function returns true if the runtime was initialized,
+   *         false otherwise.
+   */
+  bool Initialize(const char* file_name);
+
+  /**
+   * \brief Get the context of this runtime
+   *
+   * \return The context scripts are run in.
+   */
+  v8::Handle<v8::Context> GetContext() const {
+    return context_;
+  }
+
+  /**
+   * \brief Run a script in this runtime
+   *
+   * The script is subject to the limits of the module loader, see
+   * ModuleLoader::SetTimeLimit().
+   *
+   * \param source [in] The script source
+   * \param name [in] The script name used in stack traces
+   *
+   * \return The completion value of the script. If an exception was
+   *         thrown an empty handle is returned.
+   */
+  v8::Handle<v8::Value> Run(v8::Handle<v8::String> source,
+      v8::Handle<v8::Value> name);
+
+  /**
+   * \brief Restore the global object
+   *
+   * Global properties added since the runtime was initialized are
+   * deleted, and properties that were replaced, redefined or deleted are
+   * restored with their original attributes.
+   */
+  void Reset();
+
+private: // non-copyable
+  Runtime(Runtime const& that);
+
+  void operator=(Runtime const& that);
+
+private: // private data
+  std::string error_;
+  bool initialized_;
+  v8::Persistent<v8::Context> context_;
+  v8::Persistent<v8::Object> baseline_;
+  v8::Persistent<v8::Function> get_names_;
+  v8::Persistent<v8::Function> get_descriptor_;
+  v8::Persistent<v8::Function> define_property_;
+  ModuleLoader loader_;
+};
+
+/**
+ * \brief A pool of runtimes
+ *
+ * Runtimes are initialized up front and handed out one per request.
+ * Released runtimes are reset and reused, so a request only pays for
+ * running its own script.
+ */
+class MOKA_EXPORT moka::RuntimePool {
+public:
+  /**
+   * \brief Construct a runtime pool
+   *
+   * \param file_name [in] The main script of every runtime
+   * \param secure [in] Indicates if the runtimes should be secure
+   */
+  RuntimePool(const char* file_name, bool secure = false);
+
+  /// \brief Destroys all runtimes, acquired runtimes must be released first
+  ~RuntimePool();
+
+  /**
+   * \brief Get an error message after a failure to create a runtime
+   *
+   * \return A detailed error message.
+   */
+  const char* GetError() const {
+    return error_.c_str();
+  }
+
+  /**
+   * \brief Initialize runtimes ahead of use
+   *
+   * \param count [in] The number of runtimes to create
+   *
+   * \return This function returns true if the runtimes were created,
+   *         false otherwise.
+   */
+  bool Reserve(size_t count);
+
+  /**
+   * \brief Acquire a runtime
+   *
+   * A new runtime is created if no runtime is available.
+   *
+   * \return A runtime or NULL if a runtime could not be created.
+   */
+  Runtime* Acquire();
+
+  /**
+   * \brief Reset a runtime and return it to the pool
+   *
+   * \param runtime [in] A runtime returned by Acquire()
+   */
+  void Release(Runtime* runtime);
+
+private: // non-copyable
+  RuntimePool(RuntimePool const& that);
+
+  void operator=(RuntimePool const& that);
+
+private: // private methods
+  Runtime* NewRuntime();
+
+private: // private data
+  std::string error_;
+  std::string file_name_;
+  bool secure_;
+  std::vector<Runtime*> runtimes_;
+  std::vector<Runtime*> available_;
+};
+
+#endif // MOKA_RUNTIME_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -34,23 +34,35 @@
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include "moka/code-cache.h"
 #include <moka/script-module.h>
+#include "moka/script-source.h"
+#include "moka/tracer.h"
 
 namespace moka {
 
 namespace internal {
 
 ScriptModule::ScriptModule(const char* id, const char* file_name, bool secure,
-    v8::Handle<v8::Object> require, FILE* file, size_t size)
+    v8::Handle<v8::Object> require, ScriptSource* source,
+    CodeCache* code_cache, Tracer* tracer)
   : Module(id, file_name, secure, require)
-  , file_(file)
-  , size_(size)
+  , source_(source)
+  , code_cache_(code_cache)
+  , tracer_(tracer)
+  , loaded_(false) {}
+
+ScriptModule::ScriptModule(const char* id, const char* file_name, bool secure,
+    v8::Handle<v8::Object> require, v8::Handle<v8::Context> context,
+    ScriptSource* source, CodeCache* code_cache, Tracer* tracer, bool shared)
+  : Module(id, file_name, secure, require, context, shared)
+  , source_(source)
+  , code_cache_(code_cache)
+  , tracer_(tracer)
   , loaded_(false) {}
 
 ScriptModule::~ScriptModule() {
-  if (file_) {
-    ::fclose(file_);
-  }
+  delete source_;
 }
 
 v8::Handle<v8::Value> ScriptModule::Load() {
@@ -64,11 +76,12 @@ v8::Handle<v8::Value> ScriptModule::Load() {
     message.append(GetId());
     return v8::ThrowException(v8::String::New(message.c_str()));
   }
-  // Reset file pointer
-  ::rewind(file_);
-  // Create a buffer to read the script into
-  char* characters = static_cast<char*>(::malloc(size_ + 1));
-  if (!characters) {
+  // Enter the context for this module
+  v8::Context::Scope scope(GetContext());
+  // Create a string containing the script
+  Tracer::Scope read_trace(tracer_, "phase", "read", GetFileName());
+  v8::Local<v8::String> source = source_->NewString();
+  if (source.IsEmpty()) {
     char error[BUFSIZ];
     ::strerror_r(errno, error, BUFSIZ);
     std::string message("Loading module ");
@@ -77,40 +90,54 @@ v8::Handle<v8::Value> ScriptModule::Load() {
     message.append(error);
     return v8::ThrowException(v8::String::New(message.c_str()));
   }
-  // Read the script into the buffer
-  size_t size = ::fread(characters, 1, size_, file_);
-  if (size < size_) {
-    if (ferror(file_)) {
-      ::free(characters);
-      char error[BUFSIZ];
-      ::strerror_r(errno, error, BUFSIZ);
-      std::string message("Loading module ");
-      message.append(GetId());
-      message.append(": ");
-      message.append(error);
-      return v8::ThrowException(v8::String::New(message.c_str()));
-    }
-    ::clearerr(file_);
+  if (IsShared()) {
+    // Wrap the source in a function, the prefix does not contain a newline
+    // so line numbers are preserved
+    source = v8::String::Concat(
+        v8::String::New("(function (exports, require, module) {"),
+        v8::String::Concat(source, v8::String::New("\n})")));
   }
-  ::fclose(file_);
-  file_ = NULL;
-  // Enter the context for this module
-  v8::Context::Scope scope(GetContext());
-  // Create a script object from the source buffer
-  v8::Local<v8::String> source = v8::String::New(characters, size);
-  ::free(characters);
+  read_trace.End();
   v8::TryCatch try_catch;
-  // Compile the script
-  v8::Local<v8::Script> script = v8::Script::Compile(source,
-      v8::String::New(GetFileName()));
+  // Compile the script, preferring data shipped with the source
+  Tracer::Scope compile_trace(tracer_, "phase", "compile", GetFileName());
+  v8::Local<v8::Script> script;
+  v8::ScriptData* data = IsShared() ? NULL : source_->NewScriptData();
+  if (data) {
+    v8::ScriptOrigin origin(v8::String::New(GetFileName()));
+    script = v8::Script::Compile(source, &origin, data);
+    delete data;
+  } else if (code_cache_) {
+    script = code_cache_->Compile(source, GetFileName(), source_->GetMtime(),
+        source_->GetSize(), IsShared());
+  } else {
+    script = v8::Script::Compile(source, v8::String::New(GetFileName()));
+  }
+  delete source_;
+  source_ = NULL;
+  compile_trace.End();
   if (script.IsEmpty()) {
     return try_catch.ReThrow();
   }
   // Run the script
+  Tracer::Scope run_trace(tracer_, "phase", "run", GetFileName());
   v8::Local<v8::Value> result = script->Run();
   if (result.IsEmpty()) {
     return try_catch.ReThrow();
   }
+  if (IsShared()) {
+    // Call the module function
+    if (!result->IsFunction()) {
+      std::string message("Failed to evaluate module ");
+      message.append(GetId());
+      return v8::ThrowException(v8::String::New(message.c_str()));
+    }
+    v8::Handle<v8::Value> argv[3] = { GetExports(), GetRequire(), GetModule() };
+    result = v8::Function::Cast(*result)->Call(GetContext()->Global(), 3, argv);
+    if (result.IsEmpty()) {
+      return try_catch.ReThrow();
+    }
+  }
   loaded_ = true;
   return GetExports();
 }
@@ -32,7 +32,6 @@
 #ifndef MOKA_SCRIPT_MODULE_H
 #define MOKA_SCRIPT_MODULE_H
 
-#include <cstdio>
 #include "moka/module.h"
 #include <v8.h>
 
@@ -40,7 +39,10 @@ namespace moka {
 
 namespace internal {
 
+class CodeCache;
 class ScriptModule;
+class ScriptSource;
+class Tracer;
 
 } // namespace internal
 
@@ -56,11 +58,39 @@ public:
    * \param file_name [in] The absolute path of the file containing the module
    * \param secure [in] Indicates if this should be a secure module
    * \param require [in] The object implementing the 'require' function
-   * \param file [in] An open file handle (this object will own file)
-   * \param size [in] The size of file in bytes
+   * \param source [in] The module source (this object will own source)
+   * \param code_cache [in] The code cache used to compile the module
+   * \param tracer [in] The tracer loading phases are recorded in, may be
+   *                    NULL
    */
   ScriptModule(const char* id, const char* file_name, bool secure,
-      v8::Handle<v8::Object> require, FILE* file, size_t size);
+      v8::Handle<v8::Object> require, ScriptSource* source,
+      CodeCache* code_cache, Tracer* tracer);
+
+  /**
+   * \brief Construct a module from JavaScript in an existing V8 context
+   *
+   * The returned module will execute in the provided context. This
+   * constructor is intended for use by the main module and by modules
+   * loaded in shared context mode. If shared is true the source is
+   * evaluated as a function taking 'exports', 'require' and 'module'
+   * rather than as a program with its own global object.
+   *
+   * \param id [in] The ID of the new module
+   * \param file_name [in] The absolute path of the file containing the module
+   * \param secure [in] Indicates if this should be a secure module
+   * \param require [in] The object implementing the 'require' function
+   * \param context [in] The context this module should execute in
+   * \param source [in] The module source (this object will own source)
+   * \param code_cache [in] The code cache used to compile the module
+   * \param tracer [in] The tracer loading phases are recorded in, may be
+   *                    NULL
+   * \param shared [in] Indicates if context is shared with other modules
+   */
+  ScriptModule(const char* id, const char* file_name, bool secure,
+      v8::Handle<v8::Object> require, v8::Handle<v8::Context> context,
+      ScriptSource* source, CodeCache* code_cache, Tracer* tracer,
+      bool shared = false);
 
   /// \brief Destructor
   virtual ~ScriptModule();
@@ -68,16 +98,17 @@ public:
   /**
    * \brief Load a JavaScript source code module
    *
-   * This function reads JavaScript from a file handle and then attempts
-   * to compile and run the script.
+   * This function reads JavaScript from the module source and then
+   * attempts to compile and run the script.
    *
    * \return This function returns true if successful, false otherwise.
    */
   virtual v8::Handle<v8::Value> Load();
 
 private:
-  FILE* file_;
-  size_t size_;
+  ScriptSource* source_;
+  CodeCache* code_cache_;
+  Tracer* tracer_;
   bool loaded_;
 };
 
@@ -0,0 +1,125 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/script-source.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include "moka/mapped-source.h"
+#include "moka/script-source.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace moka {
+
+namespace internal {
+
+FileSource::~FileSource() {
+  if (file_) {
+    ::fclose(file_);
+  }
+}
+
+/**
+ * \brief Read a file into a new string
+ *
+ * \param fd [in] An open file descriptor
+ * \param size [in] The size of the file in bytes
+ *
+ * \return A string containing the file or an empty handle if the file
+ *         could not be read, in which case errno is set.
+ */
+static v8::Local<v8::String> ReadString(int fd, size_t size) {
+  if (!size) {
+    return v8::String::Empty();
+  }
+  char* data = static_cast<char*>(::malloc(size));
+  if (!data) {
+    return v8::Local<v8::String>();
+  }
+  size_t length = 0;
+  while (length < size) {
+    ssize_t count = ::pread(fd, data + length, size - length, length);
+    if (-1 == count) {
+      if (EINTR == errno) {
+        continue;
+      }
+      ::free(data);
+      return v8::Local<v8::String>();
+    }
+    if (!count) {
+      break;
+    }
+    length += count;
+  }
+  v8::Local<v8::String> string = v8::String::New(data, length);
+  ::free(data);
+  return string;
+}
+
+v8::Local<v8::String> FileSource::NewString() {
+  int fd = fileno(file_);
+  struct stat buf;
+  if (::fstat(fd, &buf)) {
+    return v8::Local<v8::String>();
+  }
+  v8::Local<v8::String> string;
+  if (static_cast<size_t>(buf.st_size) == size_ && buf.st_mtime == mtime_) {
+    if (!size_) {
+      string = v8::String::Empty();
+    } else {
+      MappedSource* mapped_source = MappedSource::New(fd, size_);
+      if (mapped_source) {
+        string = MappedSource::NewString(mapped_source);
+      }
+    }
+  }
+  if (string.IsEmpty()) {
+    // The file changed since it was opened or could not be mapped, copy
+    // the current contents and key the code cache on them
+    size_ = buf.st_size;
+    mtime_ = buf.st_mtime;
+    string = ReadString(fd, size_);
+    if (string.IsEmpty()) {
+      return string;
+    }
+  }
+  ::fclose(file_);
+  file_ = NULL;
+  return string;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
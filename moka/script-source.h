@@ -0,0 +1,142 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Sources of JavaScript for script modules
+ */
+
+#ifndef MOKA_SCRIPT_SOURCE_H
+#define MOKA_SCRIPT_SOURCE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+class FileSource;
+class ScriptSource;
+
+} // namespace internal
+
+} // namespace moka
+
+/// \brief The source code of a script module
+class moka::internal::ScriptSource {
+public:
+  /// \brief Destructor
+  virtual ~ScriptSource() {}
+
+  /**
+   * \brief Create a V8 string containing the source code
+   *
+   * \return A string containing the source. If the source could not be
+   *         read an empty handle is returned and errno is set.
+   */
+  virtual v8::Local<v8::String> NewString() = 0;
+
+  /**
+   * \brief Get the modification time of the source
+   *
+   * \return A modification time used to validate code cache entries.
+   */
+  virtual time_t GetMtime() const = 0;
+
+  /**
+   * \brief Get the size of the source
+   *
+   * \return The size of the source in bytes.
+   */
+  virtual size_t GetSize() const = 0;
+
+  /**
+   * \brief Get compilation data shipped with the source
+   *
+   * The data is only valid for the source as a program, i.e., it may not
+   * be used if the source is wrapped in a module function.
+   *
+   * \return New script data (the caller must delete it) or NULL if there
+   *         is no such data.
+   */
+  virtual v8::ScriptData* NewScriptData() {
+    return NULL;
+  }
+};
+
+/// \brief A script read from a file
+class moka::internal::FileSource: public moka::internal::ScriptSource {
+public:
+  /**
+   * \brief Construct a source from an open file
+   *
+   * \param file [in] An open file handle (this object will own file)
+   * \param size [in] The size of file in bytes
+   * \param mtime [in] The modification time of file
+   */
+  FileSource(FILE* file, size_t size, time_t mtime)
+    : file_(file)
+    , size_(size)
+    , mtime_(mtime) {}
+
+  /// \brief Closes the file if it has not been read
+  virtual ~FileSource();
+
+  /**
+   * \brief Map the file and create a string that references the mapping
+   *
+   * If the size or modification time of the file no longer match the
+   * values passed to the constructor the current contents are copied
+   * instead and GetSize() and GetMtime() describe the copy. The file is
+   * closed once it has been mapped or read.
+   */
+  virtual v8::Local<v8::String> NewString();
+
+  virtual time_t GetMtime() const {
+    return mtime_;
+  }
+
+  virtual size_t GetSize() const {
+    return size_;
+  }
+
+private: // non-copyable
+  FileSource(FileSource const& that);
+
+  void operator=(FileSource const& that);
+
+private: // private data
+  FILE* file_;
+  size_t size_;
+  time_t mtime_;
+};
+
+#endif // MOKA_SCRIPT_SOURCE_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,103 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/slab.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdlib>
+#include "moka/external-memory.h"
+#include "moka/slab.h"
+
+namespace moka {
+
+namespace internal {
+
+static const size_t kAlignment = 16;
+
+static const size_t kClassCount = 8;
+
+static const size_t kChunkSize = 16384;
+
+struct FreeObject {
+  FreeObject* next;
+};
+
+static __thread FreeObject* free_lists[kClassCount];
+
+// Carve a new chunk into objects of size class index
+static bool Refill(size_t index) {
+  size_t size = (index + 1) * kAlignment;
+  char* chunk = static_cast<char*>(::malloc(kChunkSize));
+  if (!chunk) {
+    return false;
+  }
+  FreeObject* head = free_lists[index];
+  for (size_t offset = 0; offset + size <= kChunkSize; offset += size) {
+    FreeObject* object = reinterpret_cast<FreeObject*>(chunk + offset);
+    object->next = head;
+    head = object;
+  }
+  free_lists[index] = head;
+  ExternalMemory::Adjust(ExternalMemory::kView, kChunkSize);
+  return true;
+}
+
+void* Slab::Allocate(size_t size) {
+  size_t index = size ? (size - 1) / kAlignment : 0;
+  if (index >= kClassCount) {
+    return ::malloc(size);
+  }
+  if (!free_lists[index] && !Refill(index)) {
+    return NULL;
+  }
+  FreeObject* object = free_lists[index];
+  free_lists[index] = object->next;
+  return object;
+}
+
+void Slab::Free(void* object, size_t size) {
+  if (!object) {
+    return;
+  }
+  size_t index = size ? (size - 1) / kAlignment : 0;
+  if (index >= kClassCount) {
+    ::free(object);
+    return;
+  }
+  FreeObject* head = static_cast<FreeObject*>(object);
+  head->next = free_lists[index];
+  free_lists[index] = head;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
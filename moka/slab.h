@@ -0,0 +1,89 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief A slab allocator for small native objects
+ */
+
+#ifndef MOKA_SLAB_H
+#define MOKA_SLAB_H
+
+#include <cstddef>
+
+namespace moka {
+
+namespace internal {
+
+class Slab;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief Allocates small objects from per-thread free lists
+ *
+ * Objects are rounded up to a multiple of 16 bytes and carved from 16 KiB
+ * chunks, one free list per size class and thread. Allocating or freeing
+ * an object is a free list push or pop. Chunks are never returned to the
+ * system, i.e., memory is recycled for objects of the same size class.
+ * Each chunk is reported to V8 as external memory once when it is
+ * allocated instead of once per object.
+ *
+ * An object may be freed on another thread than it was allocated on.
+ * Objects larger than 128 bytes are allocated with malloc().
+ */
+class moka::internal::Slab {
+public:
+  /**
+   * \brief Allocate an object
+   *
+   * \param size [in] The size of the object in bytes
+   *
+   * \return A pointer to the object or NULL if memory is exhausted.
+   */
+  static void* Allocate(size_t size);
+
+  /**
+   * \brief Free an object
+   *
+   * \param object [in] An object returned by Allocate() or NULL
+   * \param size [in] The size that was passed to Allocate()
+   */
+  static void Free(void* object, size_t size);
+
+private: // non-copyable
+  Slab();
+
+  Slab(Slab const& that);
+
+  void operator=(Slab const& that);
+};
+
+#endif // MOKA_SLAB_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -33,17 +33,32 @@
 
 #include <dlfcn.h>
 #include <moka/so-module.h>
+#include "moka/tracer.h"
 
 namespace moka {
 
 namespace internal {
 
 SoModule::SoModule(const char* id, const char* file_name, bool secure,
-    v8::Handle<v8::Object> require, void* handle, int* argc, char*** argv)
+    v8::Handle<v8::Object> require, void* handle, int* argc, char*** argv,
+    Tracer* tracer)
   : Module(id, file_name, secure, require)
   , handle_(handle)
+  , init_(NULL)
   , argc_(argc)
   , argv_(argv)
+  , tracer_(tracer)
+  , loaded_(false) {}
+
+SoModule::SoModule(const char* id, const char* file_name, bool secure,
+    v8::Handle<v8::Object> require, const module* init, int* argc,
+    char*** argv, Tracer* tracer)
+  : Module(id, file_name, secure, require)
+  , handle_(NULL)
+  , init_(init)
+  , argc_(argc)
+  , argv_(argv)
+  , tracer_(tracer)
   , loaded_(false) {}
 
 SoModule::~SoModule() {
@@ -63,21 +78,24 @@ v8::Handle<v8::Value> SoModule::Load() {
     message.append(GetId());
     return v8::ThrowException(v8::String::New(message.c_str()));
   }
-  // Verify the shared object handle is valid
-  if (!handle_) {
-    std::string message("Shared object handle is NULL for module ");
-    message.append(GetId());
-    return v8::ThrowException(v8::String::New(message.c_str()));
-  }
-  // Resolve the symbol for the initialization structure
-  const struct module* init =
-    static_cast<const struct module*>(::dlsym(handle_, "moka_module__"));
+  // Built-in modules have been resolved already
+  const struct module* init = init_;
   if (!init) {
-    std::string message("Loading module ");
-    message.append(GetId());
-    message.append(": ");
-    message.append(dlerror());
-    return v8::ThrowException(v8::String::New(message.c_str()));
+    // Verify the shared object handle is valid
+    if (!handle_) {
+      std::string message("Shared object handle is NULL for module ");
+      message.append(GetId());
+      return v8::ThrowException(v8::String::New(message.c_str()));
+    }
+    // Resolve the symbol for the initialization structure
+    init = static_cast<const struct module*>(::dlsym(handle_, "moka_module__"));
+    if (!init) {
+      std::string message("Loading module ");
+      message.append(GetId());
+      message.append(": ");
+      message.append(dlerror());
+      return v8::ThrowException(v8::String::New(message.c_str()));
+    }
   }
   // Check the major version number, must be equal
   if (init->version_major != MOKA_MODULE_VERSION_MAJOR) {
@@ -99,7 +117,9 @@ v8::Handle<v8::Value> SoModule::Load() {
     return v8::ThrowException(v8::String::New(message.c_str()));
   }
   // Call the module initialization function passing a reference to this module
+  Tracer::Scope trace(tracer_, "phase", "initialize", GetFileName());
   v8::Handle<v8::Value> exports = init->initialize(argc_, argv_);
+  trace.End();
   if (exports.IsEmpty()) {
     std::string message("Module ");
     message.append(GetId());
@@ -40,6 +40,7 @@ namespace moka {
 namespace internal {
 
 class SoModule;
+class Tracer;
 
 } // namespace internal
 
@@ -58,9 +59,29 @@ public:
    * \param handle [in] A shared object handle returned by dlopen()
    * \param argc [in/out] A pointer to the command line argument count
    * \param argv [in/out] A pointer to the command line argument vector
+   * \param tracer [in] The tracer loading phases are recorded in, may be
+   *                    NULL
    */
   SoModule(const char* id, const char* file_name, bool secure,
-      v8::Handle<v8::Object> require, void* handle, int* argc, char*** argv);
+      v8::Handle<v8::Object> require, void* handle, int* argc, char*** argv,
+      Tracer* tracer);
+
+  /**
+   * \brief Construct a module from a built-in module
+   *
+   * \param id [in] The ID of the new module
+   * \param file_name [in] The name of the module
+   * \param secure [in] Indicates if this should be a secure module
+   * \param require [in] The object implementing the 'require' function
+   * \param init [in] The module initialization structure
+   * \param argc [in/out] A pointer to the command line argument count
+   * \param argv [in/out] A pointer to the command line argument vector
+   * \param tracer [in] The tracer loading phases are recorded in, may be
+   *                    NULL
+   */
+  SoModule(const char* id, const char* file_name, bool secure,
+      v8::Handle<v8::Object> require, const module* init, int* argc,
+      char*** argv, Tracer* tracer);
 
   /// \brief Destructor
   virtual ~SoModule();
@@ -78,8 +99,10 @@ public:
 
 private:
   void* handle_;
+  const module* init_;
   int* argc_;
   char*** argv_;
+  Tracer* tracer_;
   bool loaded_;
 };
 
@@ -0,0 +1,132 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/symbols.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <map>
+#include "moka/symbols.h"
+#include <pthread.h>
+
+namespace moka {
+
+namespace internal {
+
+// Indexed by Symbols::Name
+static const char* const kNames[Symbols::kNameCount] = {
+  "closed",
+  "exports",
+  "fileno",
+  "id",
+  "module",
+  "readable",
+  "require",
+  "seekable",
+  "writable",
+  "write"
+};
+
+// Tables by isolate
+typedef std::map<v8::Isolate*, Symbols*> TableMap;
+
+static TableMap tables;
+
+static pthread_mutex_t tables_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Incremented whenever a table is freed, invalidates the cached tables
+static volatile unsigned generation = 0;
+
+// The table last used by this thread
+static __thread v8::Isolate* cached_isolate;
+
+static __thread Symbols* cached_table;
+
+static __thread unsigned cached_generation;
+
+Symbols* Symbols::Find(v8::Isolate* isolate) {
+  ::pthread_mutex_lock(&tables_mutex);
+  Symbols*& table = tables[isolate];
+  if (!table) {
+    table = new Symbols;
+  }
+  Symbols* self = table;
+  cached_isolate = isolate;
+  cached_table = self;
+  cached_generation = generation;
+  ::pthread_mutex_unlock(&tables_mutex);
+  return self;
+}
+
+v8::Handle<v8::String> Symbols::Get(Name name) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  Symbols* self = cached_table;
+  if (isolate != cached_isolate || generation != cached_generation) {
+    self = Find(isolate);
+  }
+  if (self->symbols_[name].IsEmpty()) {
+    self->symbols_[name] = v8::Persistent<v8::String>::New(
+        v8::String::NewSymbol(kNames[name]));
+  }
+  return self->symbols_[name];
+}
+
+void Symbols::Acquire(v8::Isolate* isolate) {
+  ::pthread_mutex_lock(&tables_mutex);
+  Symbols*& table = tables[isolate];
+  if (!table) {
+    table = new Symbols;
+  }
+  ++table->references_;
+  ::pthread_mutex_unlock(&tables_mutex);
+}
+
+void Symbols::Release(v8::Isolate* isolate) {
+  Symbols* self = NULL;
+  ::pthread_mutex_lock(&tables_mutex);
+  TableMap::iterator table = tables.find(isolate);
+  if (tables.end() != table && 0 == --table->second->references_) {
+    self = table->second;
+    tables.erase(table);
+    ++generation;
+  }
+  ::pthread_mutex_unlock(&tables_mutex);
+  if (self) {
+    for (int name = 0; name < kNameCount; ++name) {
+      self->symbols_[name].Dispose();
+    }
+    delete self;
+  }
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
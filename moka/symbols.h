@@ -0,0 +1,123 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Interned property names shared by the native code
+ */
+
+#ifndef MOKA_SYMBOLS_H
+#define MOKA_SYMBOLS_H
+
+#include <moka/macros.h>
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+class Symbols;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief A per-isolate table of interned property names
+ *
+ * Creating a symbol with v8::String::NewSymbol() hashes the name and
+ * looks it up in the symbol table of the heap on every call. Property
+ * names used on hot paths are instead created once per isolate and kept
+ * in persistent handles. The tables are owned by the library and keyed
+ * by isolate, the data slot of the isolate is left to the embedder.
+ *
+ * A table is referenced by every module loader initialized in its
+ * isolate and is freed when the last of them is destroyed.
+ */
+class moka::internal::Symbols {
+public:
+  /// \brief Names in the table
+  enum Name {
+    kClosed,
+    kExports,
+    kFileno,
+    kId,
+    kModule,
+    kReadable,
+    kRequire,
+    kSeekable,
+    kWritable,
+    kWrite,
+    kNameCount
+  };
+
+  /**
+   * \brief Get an interned name
+   *
+   * The name is created in the current isolate on first use. A table
+   * created outside of any module loader lives as long as the process.
+   *
+   * \param name [in] A name in the table
+   *
+   * \return The symbol for name.
+   */
+  MOKA_EXPORT static v8::Handle<v8::String> Get(Name name);
+
+  /**
+   * \brief Reference the table of an isolate
+   *
+   * \param isolate [in] The isolate to reference the table of
+   */
+  static void Acquire(v8::Isolate* isolate);
+
+  /**
+   * \brief Release a reference taken by Acquire()
+   *
+   * The table is freed with the last reference, the isolate must be
+   * alive and entered.
+   *
+   * \param isolate [in] The isolate to release the table of
+   */
+  static void Release(v8::Isolate* isolate);
+
+private: // non-copyable
+  Symbols(Symbols const& that);
+
+  void operator=(Symbols const& that);
+
+private: // private methods
+  Symbols() : references_(0) {}
+
+  static Symbols* Find(v8::Isolate* isolate);
+
+private: // private data
+  v8::Persistent<v8::String> symbols_[kNameCount];
+  unsigned references_;
+};
+
+#endif // MOKA_SYMBOLS_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,130 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/tracer.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <ctime>
+#include "moka/tracer.h"
+#include <unistd.h>
+
+namespace moka {
+
+namespace internal {
+
+Tracer::Tracer(const char* file_name)
+  : file_name_(file_name)
+  , origin_(Now()) {}
+
+Tracer::~Tracer() {
+  Write();
+}
+
+uint64_t Tracer::Now() {
+  struct timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+void Tracer::AddEvent(const char* category, const std::string& name,
+    uint64_t begin, uint64_t end, const std::string& module,
+    const std::string& parent) {
+  Event event;
+  event.category = category;
+  event.name = name;
+  event.begin = begin;
+  event.end = end;
+  event.module = module;
+  event.parent = parent;
+  events_.push_back(event);
+}
+
+/**
+ * \brief Write a JSON string
+ *
+ * \param file [in] An open file
+ * \param string [in] The string to quote and escape
+ */
+static void WriteString(FILE* file, const std::string& string) {
+  ::fputc('"', file);
+  for (std::string::size_type index = 0; index < string.length(); ++index) {
+    unsigned char c = string[index];
+    if ('"' == c || '\\' == c) {
+      ::fputc('\\', file);
+      ::fputc(c, file);
+    } else if (c < 0x20) {
+      ::fprintf(file, "\\u%04x", c);
+    } else {
+      ::fputc(c, file);
+    }
+  }
+  ::fputc('"', file);
+}
+
+bool Tracer::Write() const {
+  FILE* file = ::fopen(file_name_.c_str(), "w");
+  if (!file) {
+    return false;
+  }
+  unsigned long pid = ::getpid();
+  ::fputs("{\"traceEvents\":[", file);
+  for (std::vector<Event>::const_iterator iter = events_.begin();
+      iter != events_.end(); ++iter) {
+    ::fputs(events_.begin() == iter ? "\n" : ",\n", file);
+    ::fputs("{\"name\":", file);
+    WriteString(file, iter->name);
+    ::fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu"
+        ",\"pid\":%lu,\"tid\":1,\"args\":{", iter->category,
+        static_cast<unsigned long long>(iter->begin - origin_),
+        static_cast<unsigned long long>(iter->end - iter->begin), pid);
+    if (!iter->module.empty()) {
+      ::fputs("\"module\":", file);
+      WriteString(file, iter->module);
+    }
+    if (!iter->parent.empty()) {
+      ::fputs(iter->module.empty() ? "\"parent\":" : ",\"parent\":", file);
+      WriteString(file, iter->parent);
+    }
+    ::fputs("}}", file);
+  }
+  ::fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+  bool status = !::ferror(file);
+  if (::fclose(file)) {
+    status = false;
+  }
+  return status;
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,199 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Records module loading phases as a Chrome trace
+ */
+
+#ifndef MOKA_TRACER_H
+#define MOKA_TRACER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace moka {
+
+namespace internal {
+
+class Tracer;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief The module loading tracer
+ *
+ * Events are recorded as complete ("X") events in the Chrome trace event
+ * format and can be viewed with chrome://tracing. Each require is a
+ * "require" event named after the requested module ID whose arguments
+ * name the module and the module that required it. The loading phases
+ * ("resolve", "read", "compile", "run", "dlopen" and "initialize") are
+ * nested inside it, as are the requires of its dependencies.
+ *
+ * Each module loader owns its tracer and hands it to the module factory
+ * and the modules it creates, Scope objects record into the tracer they
+ * are given. A tracer is not thread-safe, it is only used by the thread
+ * running the module loader.
+ */
+class moka::internal::Tracer {
+public:
+  class Scope;
+
+  /**
+   * \brief Construct a tracer
+   *
+   * \param file_name [in] The file the trace is written to
+   */
+  Tracer(const char* file_name);
+
+  /// \brief Writes the trace
+  ~Tracer();
+
+  /**
+   * \brief Get the current time
+   *
+   * \return Microseconds from an arbitrary, fixed point in time.
+   */
+  static uint64_t Now();
+
+  /**
+   * \brief Record a complete event
+   *
+   * \param category [in] The event category, e.g., "require" or "phase"
+   * \param name [in] The event name
+   * \param begin [in] The start time, see Now()
+   * \param end [in] The end time, see Now()
+   * \param module [in] The absolute path of the module, may be empty
+   * \param parent [in] The absolute path of the requiring module, may be
+   *                    empty
+   */
+  void AddEvent(const char* category, const std::string& name,
+      uint64_t begin, uint64_t end, const std::string& module,
+      const std::string& parent);
+
+  /**
+   * \brief Write the trace
+   *
+   * \return This function returns true if the trace was written, false
+   *         otherwise.
+   */
+  bool Write() const;
+
+private: // non-copyable
+  Tracer(Tracer const& that);
+
+  void operator=(Tracer const& that);
+
+private: // private data
+  struct Event {
+    const char* category;
+    std::string name;
+    uint64_t begin;
+    uint64_t end;
+    std::string module;
+    std::string parent;
+  };
+
+  std::string file_name_;
+  std::vector<Event> events_;
+  uint64_t origin_;
+};
+
+/**
+ * \brief Records an event spanning the lifetime of this object
+ *
+ * Nothing is recorded if tracing is disabled.
+ */
+class moka::internal::Tracer::Scope {
+public:
+  /**
+   * \brief Start an event
+   *
+   * \param tracer [in] The tracer to record into, NULL if tracing is
+   *                    disabled
+   * \param category [in] The event category (a string literal)
+   * \param name [in] The event name
+   * \param module [in] The absolute path of the module, may be NULL
+   * \param parent [in] The absolute path of the requiring module, may be
+   *                    NULL
+   */
+  Scope(Tracer* tracer, const char* category, const char* name,
+      const char* module = NULL, const char* parent = NULL)
+    : tracer_(tracer)
+    , category_(category)
+    , begin_(0) {
+    if (tracer_) {
+      name_.assign(name);
+      module_.assign(module ? module : "");
+      parent_.assign(parent ? parent : "");
+      begin_ = Now();
+    }
+  }
+
+  /// \brief Ends the event if End() has not been called
+  ~Scope() {
+    End();
+  }
+
+  /**
+   * \brief Set the module of the event
+   *
+   * \param module [in] The absolute path of the module
+   */
+  void SetModule(const char* module) {
+    if (tracer_) {
+      module_.assign(module);
+    }
+  }
+
+  /// \brief End the event
+  void End() {
+    if (tracer_) {
+      tracer_->AddEvent(category_, name_, begin_, Now(), module_, parent_);
+      tracer_ = NULL;
+    }
+  }
+
+private: // non-copyable
+  Scope(Scope const& that);
+
+  void operator=(Scope const& that);
+
+private: // private data
+  Tracer* tracer_;
+  const char* category_;
+  std::string name_;
+  std::string module_;
+  std::string parent_;
+  uint64_t begin_;
+};
+
+#endif // MOKA_TRACER_H
+
+// vim: tabstop=2:sw=2:expandtab
@@ -49,7 +49,7 @@ public:
     v8::Local<v8::FunctionTemplate> templ = v8::FunctionTemplate::New(New);
     templ->SetClassName(v8::String::NewSymbol(name));
     templ->Inherit(TypedArray::GetTemplate());
-    templ->InstanceTemplate()->SetInternalFieldCount(1);
+    templ->InstanceTemplate()->SetInternalFieldCount(kInternalFieldCount);
     // Constants
     templ->Set(v8::String::NewSymbol("BYTES_PER_ELEMENT"),
         v8::Uint32::New(sizeof(T)),
@@ -72,7 +72,6 @@ private: // V8 interface
       delete self;
       return value;
     }
-    v8::V8::AdjustAmountOfExternalAllocatedMemory(sizeof(TypedArrayView));
     v8::Persistent<v8::Object> typed_array =
       v8::Persistent<v8::Object>::New(arguments.This());
     typed_array->SetInternalField(0, v8::External::New(self));
@@ -82,8 +81,6 @@ private: // V8 interface
 
   static void Delete(v8::Persistent<v8::Value> object, void* parameters) {
     delete static_cast<TypedArrayView*>(parameters);
-    v8::V8::AdjustAmountOfExternalAllocatedMemory(
-        static_cast<int>(-sizeof(TypedArrayView)));
     object.Dispose();
     object.Clear();
   }
@@ -101,6 +98,11 @@ private: // Private methods
   uint32_t BytesPerElement() const {
     return sizeof(T);
   }
+
+  v8::Handle<v8::Value> GetElement(uint32_t index) const {
+    return v8::Number::New(static_cast<const T*>(
+          static_cast<const void*>(GetData()))[index]);
+  }
 };
 
 #endif // MOKA_TYPED_ARRAY_VIEW_H
@@ -30,7 +30,7 @@
 #endif
 
 #include <cerrno>
-#include <cstdlib>
+#include <climits>
 #include <cstring>
 #include "moka/typed-array.h"
 #include "moka/module.h"
@@ -38,6 +38,10 @@
 
 namespace moka {
 
+// V8 indexes external array data with an int, the byte offset of a typed
+// array is not limited
+static const uint64_t kMaxLength = INT_MAX;
+
 TypedArray::TypedArray()
   : length_(0) {}
 
@@ -55,7 +59,8 @@ v8::Handle<v8::FunctionTemplate> TypedArray::GetTemplate() {
       Length);
   // Methods
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("get"),
-      v8::FunctionTemplate::New(Get)->GetFunction());
+      v8::FunctionTemplate::New(binding::Method1<TypedArray, uint32_t,
+        &TypedArray::Get>::Call)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("set"),
       v8::FunctionTemplate::New(Set)->GetFunction());
   templ->PrototypeTemplate()->Set(v8::String::NewSymbol("subarray"),
@@ -67,35 +72,14 @@ v8::Handle<v8::FunctionTemplate> TypedArray::GetTemplate() {
 // Private V8 interface
 v8::Handle<v8::Value> TypedArray::Length(v8::Local<v8::String> property,
     const v8::AccessorInfo &info) {
-  return v8::Uint32::New(static_cast<TypedArray*>(
-        info.This()->GetPointerFromInternalField(0))->GetLength());
-}
-
-v8::Handle<v8::Value> TypedArray::Get(const v8::Arguments& arguments) {
-  switch (arguments.Length()) {
-  case 1:
-    if (arguments[0]->IsUint32()) {
-      TypedArray* self = static_cast<TypedArray*>(
-          arguments.This()->GetPointerFromInternalField(0));
-      uint32_t index = arguments[0]->ToUint32()->Value();
-      if (index < self->GetLength()) {
-        return arguments.This()->Get(index);
-      }
-      return v8::Undefined();
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument one must be an unsigned long")));
-    }
-  default:
-    return v8::ThrowException(v8::Exception::TypeError(
-          v8::String::New("One argument is required")));
-  }
+  return v8::Number::New(static_cast<double>(static_cast<TypedArray*>(
+        info.This()->GetPointerFromInternalField(0))->GetLength()));
 }
 
 v8::Handle<v8::Value> TypedArray::Set(const v8::Arguments& arguments) {
   TypedArray* self = static_cast<TypedArray*>(
       arguments.This()->GetPointerFromInternalField(0));
-  uint32_t offset = 0;
+  uint64_t offset = 0;
   switch (arguments.Length()) {
   case 2:
     if (arguments[0]->IsUint32()) {
@@ -105,11 +89,8 @@ v8::Handle<v8::Value> TypedArray::Set(const v8::Arguments& arguments) {
       }
       return v8::Undefined();
     } else {
-      if (arguments[1]->IsUint32()) {
-        offset = arguments[1]->ToUint32()->Value();
-      } else {
-        return v8::ThrowException(v8::Exception::TypeError(
-              v8::String::New("Argument two must be an unsigned long")));
+      if (!binding::Unpack(arguments, 1, &offset)) {
+        return v8::Handle<v8::Value>();
       }
     }
     // Fall through
@@ -122,8 +103,9 @@ v8::Handle<v8::Value> TypedArray::Set(const v8::Arguments& arguments) {
           return v8::ThrowException(v8::Exception::RangeError(
                 v8::String::New("Offset is out of range")));
         }
-        for (uint32_t index = 0; index < self->GetLength(); ++index) {
-          arguments.This()->Set(index + offset, array->Get(index));
+        for (uint32_t index = 0; index < array->Length(); ++index) {
+          arguments.This()->Set(static_cast<uint32_t>(index + offset),
+              array->Get(index));
         }
       } else if (GetTemplate()->HasInstance(object)) {
         TypedArray* that = static_cast<TypedArray*>(
@@ -132,21 +114,22 @@ v8::Handle<v8::Value> TypedArray::Set(const v8::Arguments& arguments) {
           return v8::ThrowException(v8::Exception::RangeError(
                 v8::String::New("Offset is out of range")));
         }
-        if (self->GetBuffer() == that->GetBuffer()
-            && self->GetByteOffset() + self->GetByteLength()
-            > that->GetByteOffset()) {
-          int8_t* buffer = static_cast<int8_t*>(
-              ::malloc(self->GetByteLength()));
-          if (!buffer) {
-            return v8::ThrowException(Module::ErrnoException::New(errno));
-          }
-          ::memcpy(buffer, that->GetBuffer(), that->GetByteLength());
-          ::memcpy(static_cast<int8_t*>(self->GetBuffer()) + offset,
-              buffer, that->GetByteLength());
-          ::free(buffer);
+        if (self->BytesPerElement() == that->BytesPerElement()) {
+          // The views may share an ArrayBuffer
+          ::memmove(self->GetData() + offset * self->BytesPerElement(),
+              that->GetData(), that->GetByteLength());
         } else {
-          ::memcpy(static_cast<int8_t*>(self->GetBuffer()) + offset,
-              that->GetBuffer(), that->GetByteLength());
+          // Read every element before the first write in case the views
+          // share an ArrayBuffer
+          uint32_t length = static_cast<uint32_t>(that->GetLength());
+          v8::Local<v8::Array> values = v8::Array::New(length);
+          for (uint32_t index = 0; index < length; ++index) {
+            values->Set(index, that->GetElement(index));
+          }
+          for (uint32_t index = 0; index < length; ++index) {
+            arguments.This()->Set(static_cast<uint32_t>(index + offset),
+                values->Get(index));
+          }
         }
       } else {
         return v8::ThrowException(v8::Exception::TypeError(
@@ -168,84 +151,72 @@ v8::Handle<v8::Value> TypedArray::SubArray(
     const v8::Arguments& arguments) {
   TypedArray* self = static_cast<TypedArray*>(
       arguments.This()->GetPointerFromInternalField(0));
-  int32_t end = self->GetByteLength();
+  int64_t length = self->GetLength();
+  int64_t begin = 0, end = length;
   switch (arguments.Length()) {
   case 2:
-    if (arguments[1]->IsInt32()) {
-      end = arguments[1]->ToUint32()->Value();
-      if (0 > end) {
-        end = self->GetLength() + end;
-        if (0 > end) {
-          end = 0;
-        }
-      } else {
-        if (static_cast<uint32_t>(end) > self->GetLength()) {
-          end = self->GetLength() + 1;
-        }
-      }
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument two must be a long")));
+    if (!binding::Unpack(arguments, 1, &end)) {
+      return v8::Handle<v8::Value>();
     }
     // Fall through
   case 1:
-    if (arguments[0]->IsInt32()) {
-      int32_t start =
-        arguments[0]->ToInt32()->Value();
-      if (0 > start) {
-        start = self->GetLength() + start;
-        if (0 > start) {
-          start = 0;
-        }
-      } else {
-        if (static_cast<uint32_t>(start) > self->GetLength()) {
-          start = self->GetLength() + 1;
-        }
-      }
-      int32_t length = end - start - 1;
-      if (0 > length) {
-        length = 0;
-      }
-      v8::TryCatch try_catch;
-      v8::Handle<v8::Value> argv[3] = {
-        self->GetArrayBuffer(),
-        v8::Uint32::New(start * self->BytesPerElement()),
-        v8::Uint32::New(length)
-      };
-      v8::Handle<v8::Value> value = self->NewInstance(3, argv);
-      if (value.IsEmpty()) {
-        return try_catch.ReThrow();
-      }
-      return value;
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument one must be a long")));
+    if (!binding::Unpack(arguments, 0, &begin)) {
+      return v8::Handle<v8::Value>();
     }
+    break;
   default:
     return v8::ThrowException(v8::Exception::TypeError(
           v8::String::New("One or two arguments are required")));
   }
+  // Negative indices count from the end, both are clamped to the array
+  if (0 > begin) {
+    begin = 0 > length + begin ? 0 : length + begin;
+  } else if (begin > length) {
+    begin = length;
+  }
+  if (0 > end) {
+    end = 0 > length + end ? 0 : length + end;
+  } else if (end > length) {
+    end = length;
+  }
+  if (begin > end) {
+    end = begin;
+  }
+  v8::TryCatch try_catch;
+  v8::Handle<v8::Value> argv[3] = {
+    GetArrayBuffer(arguments.This()),
+    v8::Number::New(static_cast<double>(self->GetByteOffset()
+          + begin * self->BytesPerElement())),
+    v8::Number::New(static_cast<double>(end - begin))
+  };
+  v8::Handle<v8::Value> value = self->NewInstance(3, argv);
+  if (value.IsEmpty()) {
+    return try_catch.ReThrow();
+  }
+  return value;
+}
+
+// Private native methods
+v8::Handle<v8::Value> TypedArray::Get(uint32_t index) {
+  if (index < GetLength()) {
+    return GetElement(index);
+  }
+  return v8::Undefined();
 }
 
 // Protected
 v8::Handle<v8::Value> TypedArray::Construct(
     const v8::Arguments& arguments, v8::ExternalArrayType type) {
-  uint32_t byte_offset = 0, length = 0;
+  uint64_t byte_offset = 0, length = 0;
   switch (arguments.Length()) {
   case 3:
-    if (arguments[2]->IsUint32()) {
-      length = arguments[2]->ToUint32()->Value();
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument three must be an unsigned long")));
+    if (!binding::Unpack(arguments, 2, &length)) {
+      return v8::Handle<v8::Value>();
     }
     // Fall through
   case 2:
-    if (arguments[1]->IsUint32()) {
-      byte_offset = arguments[1]->ToUint32()->Value();
-    } else {
-      return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument two must be an unsigned long")));
+    if (!binding::Unpack(arguments, 1, &byte_offset)) {
+      return v8::Handle<v8::Value>();
     }
     if (arguments[0]->IsObject()) {
       if (!ArrayBuffer::GetTemplate()->HasInstance(arguments[0]->ToObject())) {
@@ -258,38 +229,49 @@ v8::Handle<v8::Value> TypedArray::Construct(
     }
     // Fall through
   case 1:
-    if (arguments[0]->IsUint32()) {
-      // TypedArray(unsigned long length)
-      uint32_t byte_length =
-        arguments[0]->ToUint32()->Value() * BytesPerElement();
+    if (binding::Argument<uint64_t>::Is(arguments[0])) {
+      // TypedArray(unsigned long long length)
+      length = binding::Argument<uint64_t>::Get(arguments[0]);
+      if (length > kMaxLength) {
+        return v8::ThrowException(v8::Exception::RangeError(
+              v8::String::New("Length is out of range")));
+      }
+      uint64_t byte_length = length * BytesPerElement();
       v8::Handle<v8::Value> array_buffer = ArrayBuffer::New(byte_length);
       if (array_buffer->IsUndefined()) {
         return array_buffer;
       }
       v8::Handle<v8::Value> value =
-        ArrayBufferView::Construct(array_buffer->ToObject(), 0, byte_length);
+        ArrayBufferView::Construct(arguments.This(), array_buffer->ToObject(),
+            0, byte_length);
       if (value->IsUndefined()) {
         return value;
       }
-      length_ = GetByteLength() / BytesPerElement();
-      arguments.This()->SetIndexedPropertiesToExternalArrayData(GetBuffer(),
-          type, GetLength());
+      length_ = length;
+      arguments.This()->SetIndexedPropertiesToExternalArrayData(GetData(),
+          type, static_cast<int>(GetLength()));
     } else if (arguments[0]->IsArray()) {
       // TypedArray(type[] array)
       v8::Array* array = v8::Array::Cast(*arguments[0]);
-      uint32_t byte_length = array->Length() * BytesPerElement();
+      if (array->Length() > kMaxLength) {
+        return v8::ThrowException(v8::Exception::RangeError(
+              v8::String::New("Length is out of range")));
+      }
+      uint64_t byte_length =
+        static_cast<uint64_t>(array->Length()) * BytesPerElement();
       v8::Handle<v8::Value> array_buffer = ArrayBuffer::New(byte_length);
       if (array_buffer->IsUndefined()) {
         return array_buffer;
       }
       v8::Handle<v8::Value> value =
-        ArrayBufferView::Construct(array_buffer->ToObject(), 0, byte_length);
+        ArrayBufferView::Construct(arguments.This(), array_buffer->ToObject(),
+            0, byte_length);
       if (value->IsUndefined()) {
         return value;
       }
-      length_ = GetByteLength() / BytesPerElement();
-      arguments.This()->SetIndexedPropertiesToExternalArrayData(GetBuffer(),
-          type, GetLength());
+      length_ = array->Length();
+      arguments.This()->SetIndexedPropertiesToExternalArrayData(GetData(),
+          type, static_cast<int>(GetLength()));
       for (uint32_t index = 0; index < array->Length(); ++index) {
         arguments.This()->Set(index, array->Get(index));
       }
@@ -305,31 +287,37 @@ v8::Handle<v8::Value> TypedArray::Construct(
           return array_buffer;
         }
         v8::Handle<v8::Value> value = ArrayBufferView::Construct(
-            array_buffer->ToObject(), 0, that->GetByteLength());
+            arguments.This(), array_buffer->ToObject(), 0,
+            that->GetByteLength());
         length_ = GetByteLength() / BytesPerElement();
         if (value->IsUndefined()) {
           return value;
         }
-        ::memcpy(GetBuffer(), that->GetBuffer(), that->GetByteLength());
-        arguments.This()->SetIndexedPropertiesToExternalArrayData(GetBuffer(),
-            type, GetLength());
+        ::memcpy(GetData(), that->GetData(), that->GetByteLength());
+        arguments.This()->SetIndexedPropertiesToExternalArrayData(GetData(),
+            type, static_cast<int>(GetLength()));
       } else if (ArrayBuffer::GetTemplate()->HasInstance(object)) {
         // TypedArray(ArrayBuffer buffer,
-        //            optional unsigned long byteOffset,
-        //            option unsigned long length)
+        //            optional unsigned long long byteOffset,
+        //            optional unsigned long long length)
         moka::ArrayBuffer* buffer = static_cast<moka::ArrayBuffer*>(
             object->GetPointerFromInternalField(0));
-        uint32_t byte_length;
+        if (byte_offset > buffer->GetByteLength()) {
+          return v8::ThrowException(v8::Exception::RangeError(
+                v8::String::New("Offset is out of range")));
+        }
+        uint64_t byte_length;
         if (arguments.Length() == 3) {
+          if (length > kMaxLength) {
+            return v8::ThrowException(v8::Exception::RangeError(
+                  v8::String::New("Length is out of range")));
+          }
           byte_length = length * BytesPerElement();
         } else {
           byte_length = buffer->GetByteLength() - byte_offset;
         }
-        if (byte_offset >= buffer->GetByteLength()) {
-          return v8::ThrowException(v8::Exception::RangeError(
-                v8::String::New("Offset is out of range")));
-        }
-        if (byte_offset + byte_length > buffer->GetByteLength()) {
+        if (byte_offset + byte_length > buffer->GetByteLength()
+            || byte_length / BytesPerElement() > kMaxLength) {
           return v8::ThrowException(v8::Exception::RangeError(
                 v8::String::New("Length is out of range")));
         }
@@ -341,13 +329,14 @@ v8::Handle<v8::Value> TypedArray::Construct(
                 v8::String::New(message.str().c_str())));
         }
         v8::Handle<v8::Value> value =
-          ArrayBufferView::Construct(object, byte_offset, byte_length);
+          ArrayBufferView::Construct(arguments.This(), object, byte_offset,
+              byte_length);
         if (value->IsUndefined()) {
           return value;
         }
         length_ = GetByteLength() / BytesPerElement();
-        arguments.This()->SetIndexedPropertiesToExternalArrayData(
-            static_cast<int8_t*>(GetBuffer()) + byte_offset, type, GetLength());
+        arguments.This()->SetIndexedPropertiesToExternalArrayData(GetData(),
+            type, static_cast<int>(GetLength()));
       } else {
         return v8::ThrowException(v8::Exception::TypeError(
               v8::String::New("Argument one must be an ArrayBuffer"
@@ -355,7 +344,7 @@ v8::Handle<v8::Value> TypedArray::Construct(
       }
     } else {
       return v8::ThrowException(v8::Exception::TypeError(
-            v8::String::New("Argument one must be an unsigned long,"
+            v8::String::New("Argument one must be an unsigned long long,"
               " and array or an object")));
     }
     break;
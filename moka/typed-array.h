@@ -29,6 +29,7 @@
 #define MOKA_TYPED_ARRAY_H
 
 #include "moka/array-buffer-view.h"
+#include "moka/binding.h"
 
 namespace moka {
 
@@ -40,7 +41,7 @@ class moka::TypedArray: public moka::ArrayBufferView {
 public:
   static v8::Handle<v8::FunctionTemplate> GetTemplate();
 
-  uint32_t GetLength() const {
+  uint64_t GetLength() const {
     return length_;
   }
 
@@ -48,12 +49,13 @@ private: // V8 interface
   static v8::Handle<v8::Value> Length(v8::Local<v8::String> property,
       const v8::AccessorInfo &info);
 
-  static v8::Handle<v8::Value> Get(const v8::Arguments& arguments);
-
   static v8::Handle<v8::Value> Set(const v8::Arguments& arguments);
 
   static v8::Handle<v8::Value> SubArray(const v8::Arguments& arguments);
 
+private: // Native methods
+  v8::Handle<v8::Value> Get(uint32_t index);
+
 protected: // Protected methods
   TypedArray();
 
@@ -68,8 +70,17 @@ private: // Private methods
 
   virtual uint32_t BytesPerElement() const = 0;
 
+  /**
+   * \brief Read an element without going through the JavaScript object
+   *
+   * \param index [in] An index less than GetLength()
+   *
+   * \return The element at index.
+   */
+  virtual v8::Handle<v8::Value> GetElement(uint32_t index) const = 0;
+
 private: // Private data
-  uint32_t length_;
+  uint64_t length_;
 };
 
 #endif // MOKA_TYPED_ARRAY_H
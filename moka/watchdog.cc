@@ -0,0 +1,229 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \brief Implements the API found in moka/watchdog.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "moka/watchdog.h"
+
+namespace moka {
+
+namespace internal {
+
+Watchdog* Watchdog::current_ = NULL;
+
+Watchdog::Watchdog(unsigned time_limit, unsigned cpu_limit,
+    size_t heap_limit)
+  : time_limit_(time_limit)
+  , cpu_limit_(cpu_limit)
+  , heap_limit_(heap_limit)
+  , started_(false)
+  , stopping_(false)
+  , armed_(false)
+  , reason_(NULL)
+  , time_start_(0)
+  , cpu_start_(0)
+  , heap_start_(0)
+  , cpu_clock_(CLOCK_THREAD_CPUTIME_ID)
+  , isolate_(NULL) {
+  pthread_condattr_t attr;
+  ::pthread_condattr_init(&attr);
+  ::pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  ::pthread_cond_init(&cond_, &attr);
+  ::pthread_condattr_destroy(&attr);
+  ::pthread_mutex_init(&mutex_, NULL);
+}
+
+Watchdog::~Watchdog() {
+  if (started_) {
+    ::pthread_mutex_lock(&mutex_);
+    stopping_ = true;
+    ::pthread_cond_signal(&cond_);
+    ::pthread_mutex_unlock(&mutex_);
+    ::pthread_join(thread_, NULL);
+  }
+  if (this == current_) {
+    v8::V8::RemoveGCEpilogueCallback(CheckHeap);
+    current_ = NULL;
+  }
+  ::pthread_cond_destroy(&cond_);
+  ::pthread_mutex_destroy(&mutex_);
+}
+
+bool Watchdog::Start() {
+  if (started_) {
+    return true;
+  }
+  if (time_limit_ || cpu_limit_) {
+    if (::pthread_create(&thread_, NULL, Run, this)) {
+      return false;
+    }
+    started_ = true;
+  }
+  return true;
+}
+
+const char* Watchdog::GetReason() {
+  ::pthread_mutex_lock(&mutex_);
+  const char* reason = reason_;
+  ::pthread_mutex_unlock(&mutex_);
+  return reason;
+}
+
+bool Watchdog::Arm() {
+  if (armed_) {
+    return false;
+  }
+  // Only one watchdog checks the heap at a time
+  if (heap_limit_ && !current_) {
+    current_ = this;
+    v8::HeapStatistics heap;
+    v8::V8::GetHeapStatistics(&heap);
+    heap_start_ = heap.used_heap_size();
+    v8::V8::AddGCEpilogueCallback(CheckHeap);
+  }
+  ::pthread_mutex_lock(&mutex_);
+  armed_ = true;
+  reason_ = NULL;
+  isolate_ = v8::Isolate::GetCurrent();
+  if (::pthread_getcpuclockid(::pthread_self(), &cpu_clock_)) {
+    cpu_clock_ = CLOCK_THREAD_CPUTIME_ID;
+  }
+  time_start_ = Now(CLOCK_MONOTONIC);
+  cpu_start_ = Now(cpu_clock_);
+  ::pthread_cond_signal(&cond_);
+  ::pthread_mutex_unlock(&mutex_);
+  return true;
+}
+
+void Watchdog::Disarm() {
+  if (this == current_) {
+    v8::V8::RemoveGCEpilogueCallback(CheckHeap);
+    current_ = NULL;
+  }
+  ::pthread_mutex_lock(&mutex_);
+  armed_ = false;
+  bool terminated = NULL != reason_;
+  ::pthread_mutex_unlock(&mutex_);
+  if (!terminated || v8::V8::IsExecutionTerminating(isolate_)) {
+    // Nothing requested, or the termination is being delivered
+    return;
+  }
+  // The termination may have been requested after the script returned,
+  // cancel it before it terminates the next execution
+#ifdef HAVE_V8_CANCEL_TERMINATE_EXECUTION
+  v8::V8::CancelTerminateExecution(isolate_);
+#else
+  // Deliver it to an empty script instead
+  v8::HandleScope handle_scope;
+  v8::TryCatch try_catch;
+  v8::Local<v8::Script> script =
+    v8::Script::Compile(v8::String::New("void 0"));
+  if (!script.IsEmpty()) {
+    script->Run();
+  }
+#endif
+}
+
+void Watchdog::Terminate(const char* reason) {
+  // Called with mutex_ held, only terminate the execution that is armed
+  if (armed_ && !reason_) {
+    reason_ = reason;
+    v8::V8::TerminateExecution(isolate_);
+  }
+}
+
+uint64_t Watchdog::Now(clockid_t clock) {
+  struct timespec now;
+  ::clock_gettime(clock, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+void* Watchdog::Run(void* data) {
+  Watchdog* watchdog = static_cast<Watchdog*>(data);
+  ::pthread_mutex_lock(&watchdog->mutex_);
+  while (!watchdog->stopping_) {
+    if (!watchdog->armed_ || watchdog->reason_) {
+      ::pthread_cond_wait(&watchdog->cond_, &watchdog->mutex_);
+      continue;
+    }
+    uint64_t now = Now(CLOCK_MONOTONIC);
+    uint64_t elapsed = now - watchdog->time_start_;
+    // Sleep until the next limit may be reached, CPU time never advances
+    // faster than wall time
+    uint64_t wait = static_cast<uint64_t>(-1);
+    if (watchdog->time_limit_) {
+      if (elapsed >= watchdog->time_limit_) {
+        watchdog->Terminate("time limit exceeded");
+        continue;
+      }
+      wait = watchdog->time_limit_ - elapsed;
+    }
+    if (watchdog->cpu_limit_) {
+      uint64_t used = Now(watchdog->cpu_clock_) - watchdog->cpu_start_;
+      if (used >= watchdog->cpu_limit_) {
+        watchdog->Terminate("CPU limit exceeded");
+        continue;
+      }
+      if (watchdog->cpu_limit_ - used < wait) {
+        wait = watchdog->cpu_limit_ - used;
+      }
+    }
+    uint64_t deadline = now + wait;
+    struct timespec timeout;
+    timeout.tv_sec = deadline / 1000;
+    timeout.tv_nsec = (deadline % 1000) * 1000000;
+    ::pthread_cond_timedwait(&watchdog->cond_, &watchdog->mutex_, &timeout);
+  }
+  ::pthread_mutex_unlock(&watchdog->mutex_);
+  return NULL;
+}
+
+void Watchdog::CheckHeap(v8::GCType type, v8::GCCallbackFlags flags) {
+  Watchdog* watchdog = current_;
+  if (!watchdog) {
+    return;
+  }
+  v8::HeapStatistics heap;
+  v8::V8::GetHeapStatistics(&heap);
+  if (heap.used_heap_size() > watchdog->heap_start_
+      && heap.used_heap_size() - watchdog->heap_start_
+        > watchdog->heap_limit_) {
+    ::pthread_mutex_lock(&watchdog->mutex_);
+    watchdog->Terminate("heap limit exceeded");
+    ::pthread_mutex_unlock(&watchdog->mutex_);
+  }
+}
+
+} // namespace internal
+
+} // namespace moka
+
+// vim: tabstop=2:sw=2:expandtab
@@ -0,0 +1,174 @@
+// Copyright 2011 Michael Steinert. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * The names of the copyright holder, the author, nor any contributors
+//       may be used to endorse or promote products derived from this
+//       software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * \brief Enforces execution budgets
+ */
+
+#ifndef MOKA_WATCHDOG_H
+#define MOKA_WATCHDOG_H
+
+#include <cstddef>
+#include <ctime>
+#include <pthread.h>
+#include <stdint.h>
+#include <v8.h>
+
+namespace moka {
+
+namespace internal {
+
+class Watchdog;
+
+} // namespace internal
+
+} // namespace moka
+
+/**
+ * \brief The execution watchdog
+ *
+ * While the watchdog is armed a background thread terminates V8
+ * execution (with v8::V8::TerminateExecution()) once the wall time or the
+ * CPU time of the armed thread exceed their limits. The growth of the
+ * heap since the watchdog was armed is checked after every garbage
+ * collection. Termination can not be caught by scripts, it unwinds to the
+ * code that armed the watchdog.
+ *
+ * A limit may be reached after the script returned but before the
+ * watchdog is disarmed. Disarming cancels such a termination, so it is
+ * never delivered to a later execution.
+ *
+ * The background thread sleeps until a limit may have been reached, so
+ * an execution that stays within its budget only pays for arming and
+ * disarming the watchdog.
+ */
+class moka::internal::Watchdog {
+public:
+  class Scope;
+
+  /**
+   * \brief Construct a watchdog
+   *
+   * \param time_limit [in] The wall time limit in milliseconds, zero for
+   *                        no limit
+   * \param cpu_limit [in] The CPU time limit in milliseconds, zero for no
+   *                       limit
+   * \param heap_limit [in] The limit of the growth of the V8 heap in use
+   *                        in bytes, zero for no limit
+   */
+  Watchdog(unsigned time_limit, unsigned cpu_limit, size_t heap_limit);
+
+  /// \brief Stops the background thread
+  ~Watchdog();
+
+  /**
+   * \brief Start the background thread
+   *
+   * \return This function returns true if the watchdog was started, false
+   *         otherwise.
+   */
+  bool Start();
+
+  /**
+   * \brief Get the reason execution was last terminated
+   *
+   * \return A description of the exceeded limit or NULL if execution has
+   *         not been terminated since the watchdog was last armed.
+   */
+  const char* GetReason();
+
+private: // non-copyable
+  Watchdog(Watchdog const& that);
+
+  void operator=(Watchdog const& that);
+
+private: // private methods
+  bool Arm();
+
+  void Disarm();
+
+  void Terminate(const char* reason);
+
+  static uint64_t Now(clockid_t clock);
+
+  static void* Run(void* data);
+
+  static void CheckHeap(v8::GCType type, v8::GCCallbackFlags flags);
+
+private: // private data
+  unsigned time_limit_;
+  unsigned cpu_limit_;
+  size_t heap_limit_;
+  bool started_;
+  bool stopping_;
+  bool armed_;
+  const char* reason_;
+  uint64_t time_start_;
+  uint64_t cpu_start_;
+  size_t heap_start_;
+  clockid_t cpu_clock_;
+  v8::Isolate* isolate_;
+  pthread_t thread_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  static Watchdog* current_;
+};
+
+/**
+ * \brief Arms the watchdog for the lifetime of this object
+ *
+ * Scopes nest, only the outermost scope arms the watchdog.
+ */
+class moka::internal::Watchdog::Scope {
+public:
+  /**
+   * \brief Arm the watchdog
+   *
+   * \param watchdog [in] A watchdog, may be NULL
+   */
+  explicit Scope(Watchdog* watchdog)
+    : watchdog_(watchdog && watchdog->Arm() ? watchdog : NULL) {}
+
+  /// \brief Disarms the watchdog
+  ~Scope() {
+    if (watchdog_) {
+      watchdog_->Disarm();
+    }
+  }
+
+private: // non-copyable
+  Scope(Scope const& that);
+
+  void operator=(Scope const& that);
+
+private: // private data
+  Watchdog* watchdog_;
+};
+
+#endif // MOKA_WATCHDOG_H
+
+// vim: tabstop=2:sw=2:expandtab
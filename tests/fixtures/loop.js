@@ -0,0 +1,5 @@
+'use strict';
+
+// Never returns, see test-05.sh
+while (true) {
+}
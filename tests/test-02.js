@@ -0,0 +1,66 @@
+'use strict';
+
+// Buffers and views beyond 4 GiB, needs a little over 4 GiB of memory and
+// only runs with configure --enable-large-tests
+
+var FOUR_GIB = 4294967296;
+
+function assert(condition, message) {
+	if (!condition) {
+		throw new Error('assertion failed: ' + message);
+	}
+}
+
+var x = new ArrayBuffer(FOUR_GIB + 16);
+assert(x.byteLength === FOUR_GIB + 16, 'byteLength');
+
+var d = new DataView(x);
+assert(d.byteLength === FOUR_GIB + 16, 'DataView byteLength');
+d.setUint32(FOUR_GIB - 2, 0x01020304, false);
+d.setUint32(FOUR_GIB + 4, 0xdeadbeef, true);
+assert(d.getUint32(FOUR_GIB - 2, false) === 0x01020304, 'read across 4 GiB');
+assert(d.getUint32(FOUR_GIB + 4, true) === 0xdeadbeef, 'read beyond 4 GiB');
+assert(d.getUint8(FOUR_GIB) === 3, 'byte at 4 GiB');
+assert(d.getUint8(4) === 0, 'no wrap to the start of the buffer');
+try {
+	d.getUint32(FOUR_GIB + 13, true);
+	assert(false, 'read beyond the end');
+} catch (e) {
+	assert(e.name == 'RangeError', 'read beyond the end: ' + e);
+}
+
+var e = new DataView(x, FOUR_GIB, 16);
+assert(e.byteOffset === FOUR_GIB, 'DataView byteOffset');
+assert(e.byteLength === 16, 'DataView byteLength');
+assert(e.getUint32(4, true) === 0xdeadbeef, 'DataView relative read');
+e.setDouble64(8, Math.PI, true);
+assert(d.getDouble64(FOUR_GIB + 8, true) === Math.PI, 'DataView write');
+
+var y = new Uint32Array(x, FOUR_GIB, 4);
+assert(y.byteOffset === FOUR_GIB, 'typed array byteOffset');
+assert(y.length === 4, 'typed array length');
+assert(y[1] === 0xdeadbeef, 'typed array element');
+y[0] = 42;
+assert(d.getUint32(FOUR_GIB, true) === 42, 'typed array write');
+
+var z = y.subarray(1, 3);
+assert(z.byteOffset === FOUR_GIB + 4, 'subarray byteOffset');
+assert(z.length === 2, 'subarray length');
+assert(z[0] === 0xdeadbeef, 'subarray element');
+
+var w = new Uint8Array(x, FOUR_GIB - 2, 4);
+assert(w.length === 4, 'typed array across 4 GiB');
+assert(w[0] === 1 && w[1] === 2 && w[2] === 3 && w[3] === 4,
+	'typed array elements across 4 GiB');
+
+var s = x.slice(FOUR_GIB, FOUR_GIB + 16);
+assert(s.byteLength === 16, 'slice byteLength');
+assert(new DataView(s).getUint32(4, true) === 0xdeadbeef, 'slice contents');
+assert(new DataView(s).getDouble64(8, true) === Math.PI, 'slice contents');
+
+try {
+	new Uint8Array(x);
+	assert(false, 'typed array of more than INT_MAX elements');
+} catch (e) {
+	assert(e.name == 'RangeError', 'typed array of more than INT_MAX elements');
+}
@@ -0,0 +1,90 @@
+'use strict';
+
+// 64-bit offsets and lengths on small buffers, see test-02.js for buffers
+// beyond 4 GiB
+
+var FOUR_GIB = 4294967296;
+var MAX_INTEGER = 9007199254740992;
+
+function assert(condition, message) {
+	if (!condition) {
+		throw new Error('assertion failed: ' + message);
+	}
+}
+
+function assertThrows(name, callback, message) {
+	try {
+		callback();
+	} catch (e) {
+		assert(e.name == name, message + ': threw ' + e);
+		return;
+	}
+	throw new Error('assertion failed: ' + message + ': no ' + name);
+}
+
+var x = new ArrayBuffer(16);
+assert(x.byteLength === 16, 'byteLength');
+
+// Offsets beyond 32 bits must not wrap
+var d = new DataView(x);
+d.setUint8(0, 42);
+assertThrows('RangeError', function () {
+	d.getUint8(FOUR_GIB);
+}, 'getUint8 at 4 GiB');
+assertThrows('RangeError', function () {
+	d.setUint8(FOUR_GIB, 1);
+}, 'setUint8 at 4 GiB');
+assertThrows('RangeError', function () {
+	d.getUint32(MAX_INTEGER - 1, true);
+}, 'getUint32 at 2^53 - 1');
+assert(d.getUint8(0) === 42, 'no write at 4 GiB');
+assertThrows('TypeError', function () {
+	d.getUint8(MAX_INTEGER + 2);
+}, 'getUint8 beyond 2^53');
+assertThrows('TypeError', function () {
+	d.getUint8(1.5);
+}, 'fractional offset');
+assertThrows('TypeError', function () {
+	d.getUint8(-1);
+}, 'negative offset');
+
+// Views read relative to their byte offset
+d.setUint32(8, 0xdeadbeef, true);
+var e = new DataView(x, 8);
+assert(e.byteOffset === 8, 'DataView byteOffset');
+assert(e.byteLength === 8, 'DataView byteLength');
+assert(e.getUint32(0, true) === 0xdeadbeef, 'DataView relative read');
+assertThrows('RangeError', function () {
+	new DataView(x, FOUR_GIB);
+}, 'DataView offset at 4 GiB');
+assertThrows('RangeError', function () {
+	new DataView(x, 8, FOUR_GIB);
+}, 'DataView length of 4 GiB');
+
+// Typed arrays
+var y = new Uint32Array(x, 8, 2);
+assert(y.byteOffset === 8, 'typed array byteOffset');
+assert(y.length === 2, 'typed array length');
+assert(y[0] === 0xdeadbeef, 'typed array element');
+assertThrows('RangeError', function () {
+	new Uint8Array(x, FOUR_GIB);
+}, 'typed array offset at 4 GiB');
+assertThrows('RangeError', function () {
+	new Uint8Array(x, 8, FOUR_GIB);
+}, 'typed array length of 4 GiB');
+assertThrows('RangeError', function () {
+	new Uint8Array(FOUR_GIB);
+}, 'typed array of 4 GiB elements');
+
+// subarray and slice clamp 64-bit indices
+var z = new Uint8Array(x);
+assert(z.subarray(0, FOUR_GIB).length === 16, 'subarray end at 4 GiB');
+assert(z.subarray(-FOUR_GIB).length === 16, 'subarray begin at -4 GiB');
+assert(z.subarray(FOUR_GIB).length === 0, 'subarray begin at 4 GiB');
+assert(z.subarray(-2, 16).length === 2, 'subarray from the end');
+assert(y.subarray(1).byteOffset === 12, 'subarray byteOffset');
+assert(y.subarray(1)[0] === y[1], 'subarray element');
+assert(x.slice(0, FOUR_GIB).byteLength === 16, 'slice end at 4 GiB');
+assert(x.slice(FOUR_GIB).byteLength === 0, 'slice begin at 4 GiB');
+assert(new DataView(x.slice(8)).getUint32(0, true) === 0xdeadbeef,
+	'slice contents');
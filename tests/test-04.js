@@ -0,0 +1,26 @@
+'use strict';
+
+// Native modules survive eviction, run by test-04.sh with a limit of one
+// resident module so every require evicts the modules before it
+
+function assert(condition, message) {
+	if (!condition) {
+		throw new Error('assertion failed: ' + message);
+	}
+}
+
+var io = require('io');
+var a = require('./fixtures/a.json');
+var b = require('./fixtures/b.json');
+assert(a.name === 'a', 'first JSON module');
+assert(b.name === 'b', 'second JSON module');
+assert(require('./fixtures/a.json').name === 'a', 'evicted JSON module');
+
+assert(require('io') === io, 'io was unloaded');
+assert(!require.unload('io'), 'io can be unloaded');
+
+// Call into the shared object after the evictions
+var e = new io.Error('evicted');
+assert(e.name === 'Error', 'io.Error name');
+assert(e.message === 'evicted', 'io.Error message');
+assert(io.SEEK_END === 2, 'io.SEEK_END');
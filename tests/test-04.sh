@@ -0,0 +1,5 @@
+#!/bin/sh
+# Runs test-04.js against the io module in the build tree with a limit of
+# one resident module
+MOKAPATH=moka/.libs MOKAMAXMODULES=1 \
+	exec moka/moka "${srcdir:-.}/tests/test-04.js"
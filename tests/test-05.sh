@@ -0,0 +1,29 @@
+#!/bin/sh
+# Runs scripts under the wall time limit of the watchdog: an endless loop
+# must be terminated with the reason reported, a script returning just
+# before the limit expires must succeed
+
+srcdir=${srcdir:-.}
+error=$(mktemp) || exit 1
+trap 'rm -f "$error"' EXIT
+
+if MOKATIMELIMIT=100 moka/moka "$srcdir/tests/fixtures/loop.js" \
+		2>"$error"; then
+	echo "loop.js was not terminated"
+	exit 1
+fi
+if ! grep -q 'terminated: time limit exceeded' "$error"; then
+	echo "loop.js was not terminated by the time limit:"
+	cat "$error"
+	exit 1
+fi
+
+# A limit reached after the script returned must not fail it
+for run in 1 2 3 4 5; do
+	if ! MOKATIMELIMIT=500 moka/moka "$srcdir/tests/fixtures/spin.js" \
+			2>"$error"; then
+		echo "spin.js failed in run $run:"
+		cat "$error"
+		exit 1
+	fi
+done